@@ -7,10 +7,22 @@
 #include <fstream>
 #include <algorithm>
 #include <cctype>
+#include <cstring>
+#include <memory>
+#include "FlatTables.hpp"
+#include "EngineSnapshot.hpp"
+
+// Prefix -> suggestions, stored flat so it can be served from a snapshot:
+// `prefixes` maps each prefix to an offset in `lists`, where its words are
+// stored NUL-terminated and the list ends with an empty word.
 
 class Autocomplete {
 private:
-    std::unordered_map<std::string, std::vector<std::string>> prefixMap;
+    StringTable prefixes;
+    std::vector<uint8_t> ownedLists;
+    const char* lists = nullptr;
+    size_t listsSize = 0;
+    std::shared_ptr<const SnapshotImage> snapshot;
 
     static constexpr size_t MIN_LEN = 3;
     static constexpr size_t MAX_PREFIX = 8;
@@ -31,6 +43,7 @@ public:
         std::ifstream f(lexiconPath);
         if (!f.is_open()) return;
 
+        std::unordered_map<std::string, std::vector<std::string>> prefixMap;
         std::string word;
         unsigned int id;
 
@@ -44,13 +57,49 @@ public:
             }
         }
 
-        // Cleanup
-        for (auto& [p, list] : prefixMap) {
+        // Cleanup, then flatten in prefix order so the layout is reproducible
+        std::vector<std::pair<std::string, uint32_t>> items;
+        items.reserve(prefixMap.size());
+        for (auto& [p, list] : prefixMap) items.push_back({ p, 0 });
+        std::sort(items.begin(), items.end());
+
+        ownedLists.clear();
+        for (auto& [p, offset] : items) {
+            auto& list = prefixMap[p];
             std::sort(list.begin(), list.end());
             list.erase(std::unique(list.begin(), list.end()), list.end());
             if (list.size() > 100)
                 list.resize(100);
+
+            offset = static_cast<uint32_t>(ownedLists.size());
+            for (const auto& w : list) {
+                ownedLists.insert(ownedLists.end(), w.begin(), w.end());
+                ownedLists.push_back(0);
+            }
+            ownedLists.push_back(0);
         }
+        prefixes.assign(StringTable::build(items));
+        lists = reinterpret_cast<const char*>(ownedLists.data());
+        listsSize = ownedLists.size();
+        snapshot.reset();
+    }
+
+    void saveSnapshot(SnapshotWriter& w) const {
+        w.add(SnapshotSection::AutocompletePrefixes, prefixes.data(), prefixes.byteSize());
+        w.add(SnapshotSection::AutocompleteLists, reinterpret_cast<const uint8_t*>(lists), listsSize);
+    }
+
+    bool loadSnapshot(std::shared_ptr<const SnapshotImage> image) {
+        const uint8_t *p, *l;
+        size_t n, ln;
+        if (!image->section(SnapshotSection::AutocompletePrefixes, p, n) ||
+            !image->section(SnapshotSection::AutocompleteLists, l, ln) || !prefixes.attach(p, n))
+            return false;
+        std::vector<uint8_t>().swap(ownedLists);
+        lists = reinterpret_cast<const char*>(l);
+        listsSize = ln;
+        snapshot = std::move(image);
+        return true;
     }
 
     // QUERY
@@ -59,15 +108,20 @@ public:
         if (q.size() < MIN_LEN)
             return {};
 
-        auto it = prefixMap.find(q);
-        if (it == prefixMap.end())
+        uint32_t offset;
+        if (!prefixes.find(q, offset) || offset >= listsSize)
             return {};
 
         std::vector<std::string> result;
-        for (const auto& w : it->second) {
-            result.push_back(w);
+        const char* p = lists + offset;
+        const char* end = lists + listsSize;
+        while (p < end && *p) {
+            const char* z = static_cast<const char*>(std::memchr(p, 0, end - p));
+            if (!z) break;
+            result.emplace_back(p, z);
             if (result.size() >= MAX_SUGGESTIONS)
                 break;
+            p = z + 1;
         }
 
         return result;
@@ -0,0 +1,132 @@
+#ifndef BARREL_DIRECTORY_HPP
+#define BARREL_DIRECTORY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MappedFile.hpp"
+
+// Binary term directory for the barrels ("<barrels>/directory.bin").
+// A 16-byte header followed by a dense array of fixed-size entries indexed by
+// word ID, so a lookup is one array access on the mapped file:
+//
+//   char magic[8] = "STDIR\0\0\0" | u32 version | u32 count
+//   count x DirectoryEntry
+//
+// Entries with length == 0 are terms without postings. Only the build
+// writes the file; postings of documents added later are in delta.bin.
+
+struct DirectoryEntry {
+    uint64_t offset = 0;  // byte offset of the record in its barrel
+    uint32_t length = 0;  // record size in bytes, 0 = absent
+    uint32_t df = 0;      // document frequency
+    uint32_t barrel = 0;  // barrel number
+    uint32_t reserved = 0;
+};
+static_assert(sizeof(DirectoryEntry) == 24, "DirectoryEntry must stay 24 bytes on disk");
+
+class BarrelDirectory {
+private:
+    static constexpr char MAGIC[8] = { 'S', 'T', 'D', 'I', 'R', 0, 0, 0 };
+    static constexpr uint32_t VERSION = 4; // 2: positional flag, 3: per-block max scores, 4: impacts
+    static constexpr size_t HEADER_SIZE = 16;
+
+    MappedFile map;
+    const uint8_t* entries = nullptr;
+    size_t count = 0;
+
+    static void writeHeader(std::ostream& out, uint32_t n) {
+        out.write(MAGIC, sizeof(MAGIC));
+        out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    }
+
+    static bool checkHeader(const uint8_t* p, size_t size, uint32_t& n) {
+        if (size < HEADER_SIZE || std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0) return false;
+        uint32_t version;
+        std::memcpy(&version, p + 8, sizeof(version));
+        std::memcpy(&n, p + 12, sizeof(n));
+        return version == VERSION;
+    }
+
+public:
+    // Maps an existing directory for lookups
+    bool open(const std::string& path) {
+        entries = nullptr;
+        count = 0;
+        if (!map.open(path)) return false;
+        uint32_t n;
+        if (!checkHeader(map.data(), map.size(), n)) {
+            map.close();
+            return false;
+        }
+        entries = map.data() + HEADER_SIZE;
+        // The header count may run ahead of our mapping if the file grew since
+        count = std::min<size_t>(n, (map.size() - HEADER_SIZE) / sizeof(DirectoryEntry));
+        map.advise(MappedFile::Advice::Random);
+        return true;
+    }
+
+    size_t size() const { return count; }
+
+    // Copies the entry for wordID; false if the term has no postings
+    bool find(uint32_t wordID, DirectoryEntry& out) const {
+        if (wordID >= count) return false;
+        std::memcpy(&out, entries + wordID * sizeof(DirectoryEntry), sizeof(DirectoryEntry));
+        return out.length > 0;
+    }
+
+    // ===================== WRITERS =====================
+
+    static bool write(const std::string& path, const std::vector<DirectoryEntry>& all) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        writeHeader(out, static_cast<uint32_t>(all.size()));
+        out.write(reinterpret_cast<const char*>(all.data()), all.size() * sizeof(DirectoryEntry));
+        return static_cast<bool>(out);
+    }
+
+    static bool readAll(const std::string& path, std::vector<DirectoryEntry>& all) {
+        MappedFile m;
+        uint32_t n;
+        if (!m.open(path) || !checkHeader(m.data(), m.size(), n)) return false;
+        n = static_cast<uint32_t>(std::min<size_t>(n, (m.size() - HEADER_SIZE) / sizeof(DirectoryEntry)));
+        all.resize(n);
+        std::memcpy(all.data(), m.data() + HEADER_SIZE, n * sizeof(DirectoryEntry));
+        return true;
+    }
+
+    // Overwrites (or appends, growing the array) the entry for one word ID.
+    // `currentCount` is the caller's view of the entry count and is updated.
+    static bool update(const std::string& path, uint32_t wordID, const DirectoryEntry& e, uint32_t& currentCount) {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!f.is_open()) {
+            std::ofstream create(path, std::ios::binary);
+            writeHeader(create, 0);
+            create.close();
+            f.open(path, std::ios::binary | std::ios::in | std::ios::out);
+            if (!f.is_open()) return false;
+            currentCount = 0;
+        }
+        if (wordID >= currentCount) {
+            // Grow: zero entries up to wordID, then bump the header count
+            DirectoryEntry empty;
+            f.seekp(HEADER_SIZE + static_cast<std::streamoff>(currentCount) * sizeof(DirectoryEntry));
+            for (uint32_t i = currentCount; i < wordID; ++i)
+                f.write(reinterpret_cast<const char*>(&empty), sizeof(empty));
+            f.write(reinterpret_cast<const char*>(&e), sizeof(e));
+            currentCount = wordID + 1;
+            f.seekp(12);
+            f.write(reinterpret_cast<const char*>(&currentCount), sizeof(currentCount));
+        } else {
+            f.seekp(HEADER_SIZE + static_cast<std::streamoff>(wordID) * sizeof(DirectoryEntry));
+            f.write(reinterpret_cast<const char*>(&e), sizeof(e));
+        }
+        return static_cast<bool>(f);
+    }
+};
+
+#endif
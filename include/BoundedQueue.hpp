@@ -0,0 +1,60 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Lock-free bounded single-producer / single-consumer ring buffer.
+// Exactly one thread may push and exactly one (other) thread may pop.
+// push()/pop() spin with yield() while the queue is full/empty.
+
+template <typename T>
+class SpscQueue {
+private:
+    std::vector<T> slots;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> head{ 0 }; // next slot to pop (consumer)
+    alignas(64) std::atomic<size_t> tail{ 0 }; // next slot to push (producer)
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool tryPush(T& v) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = std::move(v);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& v) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        v = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(T v) {
+        while (!tryPush(v)) std::this_thread::yield();
+    }
+
+    void pop(T& v) {
+        while (!tryPop(v)) std::this_thread::yield();
+    }
+};
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef DELTA_POSTINGS_HPP
+#define DELTA_POSTINGS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "PostingCodec.hpp"
+
+// Postings of the documents added since the index was built
+// ("<barrels>/delta.bin"). DynamicIndexer appends one entry per document, so
+// an add costs the size of that document, not of the posting lists it
+// joins; SearchEngine keeps the entries in memory per term and appends them
+// to the barrel records at query time. Added documents have higher internal
+// IDs than every built one, so the merged lists stay in doc order. A rebuild
+// folds them into the barrels and BarrelGenerator removes the file.
+//
+//   char magic[8] = "STDELTA\0" | u32 version | u32 0
+//   repeated { u32 bytes | varint docId, varint termCount,
+//              termCount x { varint wordID, varint tf<<2|mask, varint positionCount,
+//                            positionCount x varint position gap } }
+//
+// Each entry is written with one call. A torn last entry (a crash mid-write)
+// is ignored on load and cut off by the next append.
+
+class DeltaPostings {
+public:
+    // One term of an added document; positions holds tf entries or is null
+    struct DocTerm {
+        uint32_t wordID;
+        uint32_t tf;
+        int mask;
+        const uint32_t* positions;
+    };
+
+    // A term's added postings, in doc order; positions as in PostingList,
+    // kept only while every posting has them
+    struct Term {
+        PostingList list;
+        bool positional = true;
+    };
+
+private:
+    static constexpr char MAGIC[8] = { 'S', 'T', 'D', 'E', 'L', 'T', 'A', 0 };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 16;
+
+    std::unordered_map<uint32_t, Term> terms;
+    uint64_t consumed = 0; // file bytes already loaded
+    size_t docs = 0;
+
+    // Bytes of the complete entries in buf
+    static size_t completeBytes(const std::vector<char>& buf) {
+        size_t at = 0;
+        while (buf.size() - at >= sizeof(uint32_t)) {
+            uint32_t n;
+            std::memcpy(&n, buf.data() + at, sizeof(n));
+            if (buf.size() - at - sizeof(n) < n) break;
+            at += sizeof(n) + n;
+        }
+        return at;
+    }
+
+    bool addEntry(const uint8_t* p, const uint8_t* end) {
+        uint64_t doc, count, wid, tfMask, positionCount, gap;
+        if (!PostingCodec::getVarint(p, end, doc) || !PostingCodec::getVarint(p, end, count)) return false;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (!PostingCodec::getVarint(p, end, wid) || !PostingCodec::getVarint(p, end, tfMask) ||
+                !PostingCodec::getVarint(p, end, positionCount))
+                return false;
+            Term& t = terms[static_cast<uint32_t>(wid)];
+            uint32_t tf = static_cast<uint32_t>(tfMask >> 2);
+            t.list.postings.push_back({ static_cast<uint32_t>(doc), tf, static_cast<int>(tfMask & 3) });
+            if (positionCount != tf) {
+                t.positional = false;
+                t.list.positions.clear();
+            }
+            uint32_t position = 0;
+            for (uint64_t j = 0; j < positionCount; ++j) {
+                if (!PostingCodec::getVarint(p, end, gap)) return false;
+                position += static_cast<uint32_t>(gap);
+                if (t.positional) t.list.positions.push_back(position);
+            }
+        }
+        ++docs;
+        return p == end;
+    }
+
+public:
+    // Loads the entries appended since the last call (all of them on the
+    // first). A missing file is an empty delta; false if the file is not one.
+    bool refresh(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            clear();
+            return true;
+        }
+        if (consumed == 0) {
+            char header[HEADER_SIZE];
+            if (!in.read(header, sizeof(header))) return true; // still being created
+            uint32_t version;
+            std::memcpy(&version, header + 8, sizeof(version));
+            if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION) return false;
+            consumed = HEADER_SIZE;
+        }
+        in.seekg(0, std::ios::end);
+        uint64_t size = static_cast<uint64_t>(in.tellg());
+        if (size < consumed) { // replaced by a shorter file: start over
+            clear();
+            return refresh(path);
+        }
+        std::vector<char> buf(size - consumed);
+        in.seekg(static_cast<std::streamoff>(consumed));
+        if (!in.read(buf.data(), buf.size())) return false;
+
+        size_t complete = completeBytes(buf);
+        for (size_t at = 0; at < complete;) {
+            uint32_t n;
+            std::memcpy(&n, buf.data() + at, sizeof(n));
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(buf.data() + at + sizeof(n));
+            if (!addEntry(p, p + n)) return false;
+            at += sizeof(n) + n;
+        }
+        consumed += complete;
+        return true;
+    }
+
+    void clear() {
+        terms.clear();
+        consumed = 0;
+        docs = 0;
+    }
+
+    size_t documents() const { return docs; }
+    bool empty() const { return terms.empty(); }
+
+    const Term* find(uint32_t wordID) const {
+        auto it = terms.find(wordID);
+        return it == terms.end() ? nullptr : &it->second;
+    }
+
+    uint32_t df(uint32_t wordID) const {
+        const Term* t = find(wordID);
+        return t ? static_cast<uint32_t>(t->list.postings.size()) : 0;
+    }
+
+    // ===================== WRITER =====================
+
+    // Bytes of the file up to the end of its last complete entry, 0 if it
+    // is missing or not a delta file
+    static uint64_t validBytes(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        char header[HEADER_SIZE];
+        if (!in.read(header, sizeof(header)) || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0) return 0;
+        std::vector<char> body((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return HEADER_SIZE + completeBytes(body);
+    }
+
+    // Appends one document's terms at `size`, the caller's view of
+    // validBytes() (0 creates the file), and updates it. Anything past
+    // `size` (a torn entry) is overwritten and cut off; on failure the file
+    // is cut back to `size`, so nothing of the document remains.
+    static bool append(const std::string& path, uint32_t docId, const std::vector<DocTerm>& docTerms,
+                       uint64_t& size) {
+        std::string entry;
+        PostingCodec::putVarint(entry, docId);
+        PostingCodec::putVarint(entry, docTerms.size());
+        for (const auto& t : docTerms) {
+            PostingCodec::putVarint(entry, t.wordID);
+            PostingCodec::putVarint(entry, uint64_t(t.tf) << 2 | static_cast<uint64_t>(t.mask & 3));
+            PostingCodec::putVarint(entry, t.positions ? t.tf : 0);
+            uint32_t last = 0;
+            for (uint32_t i = 0; t.positions && i < t.tf; ++i) {
+                PostingCodec::putVarint(entry, t.positions[i] - last);
+                last = t.positions[i];
+            }
+        }
+
+        std::fstream out;
+        if (size < HEADER_SIZE) {
+            out.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+            if (!out.is_open()) return false;
+            uint32_t zero = 0;
+            out.write(MAGIC, sizeof(MAGIC));
+            out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+            out.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+            size = HEADER_SIZE;
+        } else {
+            out.open(path, std::ios::binary | std::ios::in | std::ios::out);
+            if (!out.is_open()) return false;
+            out.seekp(static_cast<std::streamoff>(size));
+        }
+        uint32_t n = static_cast<uint32_t>(entry.size());
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        out.write(entry.data(), entry.size());
+        out.close();
+        uint64_t end = size + sizeof(n) + entry.size();
+        std::error_code ec;
+        if (!out) {
+            std::filesystem::resize_file(path, size, ec);
+            return false;
+        }
+        if (std::filesystem::file_size(path, ec) > end) std::filesystem::resize_file(path, end, ec);
+        if (ec) return false;
+        size = end;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef DOC_LENGTHS_HPP
+#define DOC_LENGTHS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MappedFile.hpp"
+#include "Ranking.hpp"
+
+// Document length column for BM25 ("doclens.bin" next to AUC.csv): tokens
+// per document over all fields after stop word removal, indexed by internal
+// doc ID, plus the collection statistics of the build.
+//
+//   char magic[8] = "STLENS\0\0" | u32 version | u32 count | u32 docs | u32 0 | f64 avgLength
+//   count x u32 length
+//
+// DynamicIndexer appends the lengths of added documents but leaves the
+// statistics alone, so added documents are scored on the same scale as the
+// stored impacts; the next build refreshes them. Docs past the mapping count
+// as average length.
+
+class DocLengths {
+private:
+    static constexpr char MAGIC[8] = { 'S', 'T', 'L', 'E', 'N', 'S', 0, 0 };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 32;
+
+    MappedFile map;
+    const uint8_t* lengths = nullptr;
+    size_t count = 0;
+    CollectionStats st;
+
+    static bool checkHeader(const uint8_t* p, size_t size, uint32_t& n, CollectionStats& s) {
+        if (size < HEADER_SIZE || std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0) return false;
+        uint32_t version;
+        std::memcpy(&version, p + 8, sizeof(version));
+        std::memcpy(&n, p + 12, sizeof(n));
+        std::memcpy(&s.docs, p + 16, sizeof(s.docs));
+        std::memcpy(&s.avgLength, p + 24, sizeof(s.avgLength));
+        n = static_cast<uint32_t>(std::min<size_t>(n, (size - HEADER_SIZE) / sizeof(uint32_t)));
+        return version == VERSION && s.docs > 0 && s.avgLength > 0.0;
+    }
+
+public:
+    bool open(const std::string& path) {
+        lengths = nullptr;
+        count = 0;
+        if (!map.open(path)) return false;
+        uint32_t n;
+        if (!checkHeader(map.data(), map.size(), n, st)) {
+            map.close();
+            return false;
+        }
+        lengths = map.data() + HEADER_SIZE;
+        count = n;
+        map.advise(MappedFile::Advice::Random);
+        return true;
+    }
+
+    bool isOpen() const { return lengths != nullptr; }
+    const CollectionStats& stats() const { return st; }
+
+    double length(uint32_t doc) const {
+        if (doc >= count) return st.avgLength;
+        uint32_t v;
+        std::memcpy(&v, lengths + doc * sizeof(uint32_t), sizeof(v));
+        return v;
+    }
+
+    // ===================== WRITERS =====================
+
+    // Statistics of a column; docs is the number of documents indexed (the
+    // slots of skipped lines stay 0 and do not count toward the average)
+    static CollectionStats statsOf(const std::vector<uint32_t>& all, uint32_t docs) {
+        uint64_t total = 0;
+        for (uint32_t v : all) total += v;
+        return { docs, docs ? static_cast<double>(total) / docs : 0.0 };
+    }
+
+    static bool write(const std::string& path, const std::vector<uint32_t>& all, const CollectionStats& s) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        uint32_t n = static_cast<uint32_t>(all.size()), zero = 0;
+        out.write(MAGIC, sizeof(MAGIC));
+        out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        out.write(reinterpret_cast<const char*>(&s.docs), sizeof(s.docs));
+        out.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+        out.write(reinterpret_cast<const char*>(&s.avgLength), sizeof(s.avgLength));
+        out.write(reinterpret_cast<const char*>(all.data()), all.size() * sizeof(uint32_t));
+        return static_cast<bool>(out);
+    }
+
+    static bool readAll(const std::string& path, std::vector<uint32_t>& all, CollectionStats& s) {
+        MappedFile m;
+        uint32_t n;
+        if (!m.open(path) || !checkHeader(m.data(), m.size(), n, s)) return false;
+        all.resize(n);
+        std::memcpy(all.data(), m.data() + HEADER_SIZE, n * sizeof(uint32_t));
+        return true;
+    }
+
+    // Sets the length of one doc, growing the column (zero-filled) past the
+    // end. `currentCount` is the caller's view of the count and is updated.
+    static bool update(const std::string& path, uint32_t doc, uint32_t length, uint32_t& currentCount) {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!f.is_open()) return false;
+        if (doc >= currentCount) {
+            uint32_t zero = 0;
+            f.seekp(HEADER_SIZE + static_cast<std::streamoff>(currentCount) * sizeof(uint32_t));
+            for (uint32_t i = currentCount; i < doc; ++i)
+                f.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+            f.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            currentCount = doc + 1;
+            f.seekp(12);
+            f.write(reinterpret_cast<const char*>(&currentCount), sizeof(currentCount));
+        } else {
+            f.seekp(HEADER_SIZE + static_cast<std::streamoff>(doc) * sizeof(uint32_t));
+            f.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        }
+        return static_cast<bool>(f);
+    }
+};
+
+#endif
@@ -0,0 +1,313 @@
+#ifndef DOC_STORE_HPP
+#define DOC_STORE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.hpp"
+#include "FlatTables.hpp"
+#include "JsonFields.hpp"
+
+// Compact store of the fields /search returns, built at index time
+// ("docs.bin" next to AUC.csv) so results never touch the raw dataset.
+//
+// A document is stored as the members of its result object, with each value's
+// raw JSON text copied from the dataset line ("id":"0704.0001","title":...),
+// so serving it is a copy: no parse, no re-serialization. Documents are packed
+// in doc ID order into blocks of about BLOCK_SIZE bytes, each compressed
+// with the small LZ coder below; a lookup decompresses one block.
+//
+//   char magic[8] = "STDOCS\0\0" | u32 version | u32 docCount | u32 blockCount | u32 0 | u64 tableOffset
+//   block data
+//   at tableOffset: blockCount x { u64 offset, u32 packedSize, u32 rawSize }
+//                   docCount   x { u32 block, u32 offset, u32 length }   (length 0 = not stored)
+
+// ===================== LZ BLOCK CODER =====================
+
+// LZ77 in the LZ4 sequence layout: token (literal count << 4 | match length - 4),
+// optional 255-run length extensions, literals, u16 match offset. The last
+// sequence has literals only. Favors decode speed over ratio.
+
+namespace lz {
+
+constexpr size_t MIN_MATCH = 4;
+// The compressor keeps shorter matches as literals: on prose they save a few
+// bytes each but cost a decode step, and 6 decodes over twice as fast as 4
+constexpr size_t USEFUL_MATCH = 6;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 13;
+
+inline void putLength(std::vector<uint8_t>& out, size_t extra) {
+    for (; extra >= 255; extra -= 255) out.push_back(255);
+    out.push_back(static_cast<uint8_t>(extra));
+}
+
+inline void compress(const uint8_t* src, size_t n, std::vector<uint8_t>& out) {
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, UINT32_MAX);
+    auto read32 = [&](size_t i) { uint32_t v; std::memcpy(&v, src + i, 4); return v; };
+    auto sequence = [&](size_t anchor, size_t literals, size_t match, size_t offset) {
+        size_t m = match ? match - MIN_MATCH : 0;
+        out.push_back(static_cast<uint8_t>((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(m, 15)));
+        if (literals >= 15) putLength(out, literals - 15);
+        out.insert(out.end(), src + anchor, src + anchor + literals);
+        if (!match) return;
+        out.push_back(static_cast<uint8_t>(offset));
+        out.push_back(static_cast<uint8_t>(offset >> 8));
+        if (m >= 15) putLength(out, m - 15);
+    };
+
+    size_t anchor = 0, i = 0;
+    while (i + MIN_MATCH <= n) {
+        uint32_t v = read32(i);
+        uint32_t& slot = table[(v * 2654435761u) >> (32 - HASH_BITS)];
+        size_t cand = slot;
+        slot = static_cast<uint32_t>(i);
+        if (cand == UINT32_MAX || i - cand > MAX_OFFSET || read32(cand) != v) {
+            ++i;
+            continue;
+        }
+        size_t len = MIN_MATCH;
+        while (i + len < n && src[cand + len] == src[i + len]) ++len;
+        if (len < USEFUL_MATCH) {
+            ++i;
+            continue;
+        }
+        sequence(anchor, i - anchor, len, i - cand);
+        i += len;
+        anchor = i;
+    }
+    sequence(anchor, n - anchor, 0, 0);
+}
+
+// Copies are done 16 bytes at a time and may write up to this far past the
+// decoded data, so the output buffer needs that much slack
+constexpr size_t SLACK = 16;
+
+// Decodes into dst, which holds rawSize + SLACK bytes; false if malformed.
+// Stops early, successfully, once the first `want` bytes are out.
+inline bool decompress(const uint8_t* p, size_t n, uint8_t* dst, size_t rawSize, size_t want = SIZE_MAX) {
+    const uint8_t* end = p + n;
+    size_t o = 0;
+    auto length = [&](size_t& v) {
+        uint8_t b;
+        do {
+            if (p >= end) return false;
+            b = *p++;
+            v += b;
+        } while (b == 255);
+        return true;
+    };
+    while (p < end && o < want) {
+        uint8_t token = *p++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !length(literals)) return false;
+        if (literals > static_cast<size_t>(end - p) || literals > rawSize - o) return false;
+        if (static_cast<size_t>(end - p) >= literals + SLACK) {
+            for (size_t k = 0; k < literals; k += 16) std::memcpy(dst + o + k, p + k, 16);
+        } else if (literals) {
+            std::memcpy(dst + o, p, literals);
+        }
+        p += literals;
+        o += literals;
+        if (p == end) break;
+
+        if (end - p < 2) return false;
+        size_t offset = p[0] | (static_cast<size_t>(p[1]) << 8);
+        p += 2;
+        size_t match = token & 15;
+        if (match == 15 && !length(match)) return false;
+        match += MIN_MATCH;
+        if (offset == 0 || offset > o || match > rawSize - o) return false;
+        if (offset >= 16) {
+            for (size_t k = 0; k < match; k += 16) std::memcpy(dst + o + k, dst + o - offset + k, 16);
+            o += match;
+        } else {
+            // Byte by byte: the match overlaps the bytes it produces
+            for (size_t k = 0; k < match; ++k, ++o) dst[o] = dst[o - offset];
+        }
+    }
+    return o == rawSize || (o >= want && o <= rawSize);
+}
+
+} // namespace lz
+
+// ===================== STORE =====================
+
+class DocStore {
+private:
+    friend class DocStoreWriter;
+    static constexpr char MAGIC[8] = { 'S', 'T', 'D', 'O', 'C', 'S', 0, 0 };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 32;
+    static constexpr size_t BLOCK_ROW = 16;
+    static constexpr size_t DOC_ROW = 12;
+
+    MappedFile map;
+    const uint8_t* blockRows = nullptr;
+    const uint8_t* docRows = nullptr;
+    uint32_t docCount = 0;
+    uint32_t blockCount = 0;
+
+public:
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    // Result fields, in output order; absent ones are left out
+    static constexpr std::string_view FIELDS[] = { "id", "title", "authors", "abstract", "categories", "update_date" };
+
+    // Appends a dataset line's result fields as object members ("k":v,...);
+    // false if the line is not a JSON object or has none of them
+    static bool extractFields(std::string_view line, std::string& out) {
+        JsonRecord rec{ FIELDS[0], FIELDS[1], FIELDS[2], FIELDS[3], FIELDS[4], FIELDS[5] };
+        if (!rec.scan(line)) return false;
+        size_t start = out.size();
+        for (size_t i = 0; i < std::size(FIELDS); ++i) {
+            if (!rec.has(i)) continue;
+            if (out.size() > start) out += ',';
+            out += '"';
+            out += FIELDS[i];
+            out += "\":";
+            out += rec.raw(i);
+        }
+        return out.size() > start;
+    }
+
+    bool open(const std::string& path) {
+        docCount = blockCount = 0;
+        if (!map.open(path)) return false;
+        const uint8_t* p = map.data();
+        if (map.size() < HEADER_SIZE || std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0 ||
+            flat::readU32(p + 8) != VERSION) {
+            map.close();
+            return false;
+        }
+        uint32_t docs = flat::readU32(p + 12), blocks = flat::readU32(p + 16);
+        uint64_t tableOffset = flat::readU64(p + 24);
+        uint64_t tableSize = uint64_t(blocks) * BLOCK_ROW + uint64_t(docs) * DOC_ROW;
+        if (tableOffset > map.size() || map.size() - tableOffset < tableSize) {
+            map.close();
+            return false;
+        }
+        blockRows = p + tableOffset;
+        docRows = blockRows + size_t(blocks) * BLOCK_ROW;
+        docCount = docs;
+        blockCount = blocks;
+        map.advise(MappedFile::Advice::Random);
+        return true;
+    }
+
+    bool isOpen() const { return map.isOpen(); }
+    size_t size() const { return docCount; }
+
+    // Appends the stored result fields of doc (see extractFields); false if
+    // the doc is not in the store or its block is damaged
+    bool appendFields(uint32_t doc, std::string& out) const {
+        if (doc >= docCount) return false;
+        const uint8_t* d = docRows + size_t(doc) * DOC_ROW;
+        uint32_t block = flat::readU32(d), offset = flat::readU32(d + 4), length = flat::readU32(d + 8);
+        if (length == 0 || block >= blockCount) return false;
+
+        const uint8_t* b = blockRows + size_t(block) * BLOCK_ROW;
+        uint64_t at = flat::readU64(b);
+        uint32_t packed = flat::readU32(b + 8), raw = flat::readU32(b + 12);
+        if (at + packed > map.size() || uint64_t(offset) + length > raw) return false;
+
+        // Only the block prefix up to the document is decoded
+        std::vector<uint8_t> buf(raw + lz::SLACK);
+        if (!lz::decompress(map.data() + at, packed, buf.data(), raw, size_t(offset) + length)) return false;
+        out.append(reinterpret_cast<const char*>(buf.data()) + offset, length);
+        return true;
+    }
+};
+
+// Streams documents into a doc store file. Documents may arrive in any doc
+// ID order, but blocks are cut in arrival order.
+
+class DocStoreWriter {
+private:
+    std::string path;
+    std::ofstream out;
+    std::vector<uint8_t> blockTable;
+    std::vector<uint32_t> docTable; // 3 words per doc ID
+    std::string block;              // uncompressed current block
+    std::string fields;
+    std::vector<uint8_t> packed;
+    uint64_t written = 0;
+    uint64_t rawBytes = 0;
+    uint32_t blocks = 0;
+    uint32_t stored = 0;
+
+    bool flushBlock() {
+        if (block.empty()) return true;
+        packed.clear();
+        lz::compress(reinterpret_cast<const uint8_t*>(block.data()), block.size(), packed);
+        flat::putU64(blockTable, written);
+        flat::putU32(blockTable, static_cast<uint32_t>(packed.size()));
+        flat::putU32(blockTable, static_cast<uint32_t>(block.size()));
+        out.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+        written += packed.size();
+        rawBytes += block.size();
+        ++blocks;
+        block.clear();
+        return static_cast<bool>(out);
+    }
+
+public:
+    explicit DocStoreWriter(std::string file) : path(std::move(file)) {}
+
+    bool open() {
+        out.open(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "[DocStore][ERROR] Cannot open " << path << "\n";
+            return false;
+        }
+        char header[32] = {};
+        out.write(header, sizeof(header)); // filled in by close()
+        written = sizeof(header);
+        return true;
+    }
+
+    // Stores the result fields of one dataset line; false if it has none
+    bool add(uint32_t docId, std::string_view line) {
+        fields.clear();
+        if (!DocStore::extractFields(line, fields)) return false;
+        if (docTable.size() < (size_t(docId) + 1) * 3) docTable.resize((size_t(docId) + 1) * 3, 0);
+        docTable[size_t(docId) * 3] = blocks;
+        docTable[size_t(docId) * 3 + 1] = static_cast<uint32_t>(block.size());
+        docTable[size_t(docId) * 3 + 2] = static_cast<uint32_t>(fields.size());
+        block += fields;
+        ++stored;
+        return block.size() < DocStore::BLOCK_SIZE || flushBlock();
+    }
+
+    bool close() {
+        if (!flushBlock()) return false;
+        uint64_t tableOffset = written;
+        out.write(reinterpret_cast<const char*>(blockTable.data()), blockTable.size());
+        out.write(reinterpret_cast<const char*>(docTable.data()), docTable.size() * sizeof(uint32_t));
+
+        std::vector<uint8_t> header(DocStore::MAGIC, DocStore::MAGIC + 8);
+        flat::putU32(header, DocStore::VERSION);
+        flat::putU32(header, static_cast<uint32_t>(docTable.size() / 3));
+        flat::putU32(header, blocks);
+        flat::putU32(header, 0);
+        flat::putU64(header, tableOffset);
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(header.data()), header.size());
+        out.close();
+        if (!out) {
+            std::cerr << "[DocStore][ERROR] Failed writing " << path << "\n";
+            return false;
+        }
+        std::cout << "[DocStore] " << stored << " documents in " << blocks << " blocks, "
+                  << rawBytes / 1024 << " KB -> " << (tableOffset - 32) / 1024 << " KB, written to " << path << "\n";
+        return true;
+    }
+};
+
+#endif
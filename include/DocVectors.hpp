@@ -0,0 +1,168 @@
+#ifndef DOC_VECTORS_HPP
+#define DOC_VECTORS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "FlatTables.hpp"
+#include "Hnsw.hpp"
+#include "MappedFile.hpp"
+#include "VectorMath.hpp"
+
+// Precomputed document embeddings ("docvecs.bin"), one row per internal doc
+// ID, memory-mapped and searched through an HNSW graph.
+//
+//   char magic[8] = "STDVECS\0" | u32 version | u32 count | u32 dim | u32 indexed | 2 x u32 0
+//   count x dim f32 rows, unit length, or all zero for a doc without one
+//   indexed x u32 doc IDs that have a vector, ascending
+//
+// The rows are used in place from the mapping, so opening the file reads
+// none of them; only the graph over the indexed docs lives on the heap. It
+// is cached at "<path>.hnsw" and rebuilt when missing or stale. Documents
+// added after the file was written have no vector and are only found
+// lexically.
+
+class DocVectors {
+private:
+    static constexpr char MAGIC[8] = { 'S', 'T', 'D', 'V', 'E', 'C', 'S', 0 };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 32;
+
+    MappedFile map;
+    const float* rows = nullptr;
+    uint32_t count = 0;
+    uint32_t dim = 0;
+    std::vector<uint32_t> nodes; // graph node -> doc ID
+    HnswIndex graph;
+
+public:
+    bool open(const std::string& path) {
+        rows = nullptr;
+        count = dim = 0;
+        nodes.clear();
+        graph = HnswIndex();
+        map.close();
+        if (!map.open(path)) return false;
+        const uint8_t* p = map.data();
+        uint32_t version, n, d, indexed;
+        if (map.size() < HEADER_SIZE || std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0) return false;
+        std::memcpy(&version, p + 8, sizeof(version));
+        std::memcpy(&n, p + 12, sizeof(n));
+        std::memcpy(&d, p + 16, sizeof(d));
+        std::memcpy(&indexed, p + 20, sizeof(indexed));
+        uint64_t rowBytes = uint64_t(n) * d * sizeof(float);
+        if (version != VERSION || d == 0 || indexed > n ||
+            map.size() < HEADER_SIZE + rowBytes + uint64_t(indexed) * sizeof(uint32_t)) {
+            map.close();
+            return false;
+        }
+        nodes.resize(indexed);
+        std::memcpy(nodes.data(), p + HEADER_SIZE + rowBytes, indexed * sizeof(uint32_t));
+        if (!std::is_sorted(nodes.begin(), nodes.end()) || (!nodes.empty() && nodes.back() >= n)) {
+            nodes.clear();
+            map.close();
+            return false;
+        }
+        rows = reinterpret_cast<const float*>(p + HEADER_SIZE);
+        count = n;
+        dim = d;
+        map.advise(MappedFile::Advice::Random);
+        if (nodes.empty()) return true;
+
+        uint64_t fingerprint = flat::hash({ reinterpret_cast<const char*>(nodes.data()),
+                                            nodes.size() * sizeof(uint32_t) }) ^
+                               (map.size() * 0x9E3779B97F4A7C15ull);
+        VectorView view{ rows, dim, nodes.data() };
+        uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
+        if (!graph.load(path + ".hnsw", view, nodeCount, fingerprint)) {
+            std::cout << "[DocVectors] Building the graph over " << nodeCount << " documents...\n";
+            graph.build(view, nodeCount);
+            if (!graph.save(path + ".hnsw", fingerprint))
+                std::cerr << "[DocVectors][WARN] Cannot cache the graph at " << path << ".hnsw\n";
+        }
+        return true;
+    }
+
+    bool isOpen() const { return rows != nullptr; }
+    uint32_t dimensions() const { return dim; }
+    size_t indexed() const { return nodes.size(); }
+
+    // The doc's unit vector, nullptr if it has none
+    const float* vector(uint32_t doc) const {
+        if (!std::binary_search(nodes.begin(), nodes.end(), doc)) return nullptr;
+        return rows + size_t(doc) * dim;
+    }
+
+    // The k docs whose vectors are most similar to the unit vector q, as
+    // (cosine, doc ID), most similar first
+    std::vector<HnswIndex::Hit> nearest(const float* q, size_t k, size_t ef = HnswIndex::DEFAULT_EF) const {
+        std::vector<HnswIndex::Hit> hits = graph.search(q, k, std::max(ef, k));
+        for (auto& h : hits) h.second = nodes[h.second];
+        return hits;
+    }
+
+    // ===================== WRITER =====================
+
+    // Writes the file one row at a time, in any doc order, without holding
+    // the matrix: each row is written at its offset and rows never put read
+    // back as zero. Only the list of indexed docs is kept until close().
+    class Writer {
+    private:
+        std::ofstream out;
+        std::string path;
+        uint32_t count = 0;
+        uint32_t dim = 0;
+        std::vector<uint32_t> indexed;
+
+    public:
+        // count x dim rows; truncates the file and drops its stale graph
+        bool open(const std::string& p, uint32_t n, uint32_t d) {
+            path = p;
+            count = n;
+            dim = d;
+            indexed.clear();
+            std::error_code ec;
+            std::filesystem::remove(path + ".hnsw", ec);
+            out.open(path, std::ios::binary | std::ios::trunc);
+            return out.is_open() && dim > 0;
+        }
+
+        // Normalizes v in place and stores it as the doc's row; a later put
+        // for the same doc replaces it. False if the doc is out of range or
+        // v cannot be normalized (zero, non-finite).
+        bool put(uint32_t doc, float* v) {
+            if (!out.is_open() || doc >= count || !vecmath::normalize(v, dim)) return false;
+            out.seekp(static_cast<std::streamoff>(HEADER_SIZE + uint64_t(doc) * dim * sizeof(float)));
+            out.write(reinterpret_cast<const char*>(v), dim * sizeof(float));
+            indexed.push_back(doc);
+            return static_cast<bool>(out);
+        }
+
+        // Appends the indexed doc list and writes the header last, so a file
+        // cut short is never taken for a complete one
+        bool close() {
+            if (!out.is_open()) return false;
+            std::sort(indexed.begin(), indexed.end());
+            indexed.erase(std::unique(indexed.begin(), indexed.end()), indexed.end());
+            uint32_t m = static_cast<uint32_t>(indexed.size()), zero[2] = { 0, 0 };
+            out.seekp(static_cast<std::streamoff>(HEADER_SIZE + uint64_t(count) * dim * sizeof(float)));
+            out.write(reinterpret_cast<const char*>(indexed.data()), indexed.size() * sizeof(uint32_t));
+            out.seekp(0);
+            out.write(MAGIC, sizeof(MAGIC));
+            out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            out.write(reinterpret_cast<const char*>(&dim), sizeof(dim));
+            out.write(reinterpret_cast<const char*>(&m), sizeof(m));
+            out.write(reinterpret_cast<const char*>(zero), sizeof(zero));
+            out.close();
+            return static_cast<bool>(out);
+        }
+    };
+};
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef DYNAMIC_INDEXER_HPP
 #define DYNAMIC_INDEXER_HPP
 
+#include <atomic>
 #include <fstream>
 #include <string>
 #include <unordered_map>
@@ -9,42 +10,47 @@
 #include <filesystem>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <json.hpp>
+#include "PostingCodec.hpp"
+#include "barrels.hpp"
+#include "BarrelDirectory.hpp"
+#include "DeltaPostings.hpp"
+#include "DocLengths.hpp"
+#include "Ranking.hpp"
+#include "JsonFields.hpp"
+#include "Tokenizer.hpp"
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
 
 class DynamicIndexer {
 private:
-    static constexpr int TOTAL_BARRELS = 100;
-
     std::string datasetPath;
     std::string lexiconPath;
     std::string forwardPath;
     std::string docMapPath;
     std::string barrelDir;
+    std::string docLengthsPath; // doclens.bin next to the doc map
+    std::string deltaPath;      // postings of added documents, in the barrel directory
 
     unsigned int nextWordID = 0;
     unsigned int nextInternalDocID = 0;
     unsigned int nextNewID = 0;
 
-    std::unordered_map<std::string, unsigned int> lexicon;
+    std::unordered_map<std::string, unsigned int, tokenizer::StringHash, std::equal_to<>> lexicon;
     std::vector<std::pair<std::string, unsigned int>> newlyAddedWords;
+    bool positional = false;  // added postings get positions if the index has them
+    uint64_t deltaBytes = 0;  // valid length of the delta file
+    uint32_t lengthCount = 0; // entries in the doc length column
+    bool lengths = false;     // the index has a doc length column
+    std::atomic<uint64_t> generationCount{ 0 }; // bumped by every added document
 
-    std::unordered_set<std::string> stopWords{
-        "the","and","is","in","at","of","on","for","to","a","an","that","it"
-    };
+    Tokenizer tokens;
 
     // ---------------- HELPERS ----------------
 
-    std::string clean(const std::string& w) {
-        std::string r;
-        for (char c : w)
-            if (std::isalpha(static_cast<unsigned char>(c)))
-                r += std::tolower(c);
-        return r;
-    }
-
     void loadLexicon() {
         std::ifstream f(lexiconPath);
         std::string w;
@@ -55,23 +61,74 @@ private:
         }
     }
 
+    // Internal IDs are dataset line numbers, and lines the build could not
+    // parse get no doc map row, so the next ID follows the largest one in
+    // use rather than the row count. Run after loadDocLengths: a length
+    // column that reaches further also counts.
     void loadDocCounters() {
         std::ifstream f(docMapPath);
         std::string line;
         std::getline(f, line);
         while (std::getline(f, line)) {
-            nextInternalDocID++;
-            if (line.find("new") != std::string::npos)
-                nextNewID++;
+            const char* p = line.c_str();
+            char* end;
+            unsigned long id = std::strtoul(p, &end, 10);
+            if (end == p || *end != '|') continue;
+            nextInternalDocID = std::max(nextInternalDocID, static_cast<unsigned int>(id));
+            size_t at = line.find("|new");
+            if (at != std::string::npos) {
+                unsigned long n = std::strtoul(line.c_str() + at + 4, &end, 10);
+                nextNewID = std::max(nextNewID, static_cast<unsigned int>(n));
+            }
         }
+        if (lengthCount > 0) nextInternalDocID = std::max(nextInternalDocID, lengthCount - 1);
+    }
+
+    void loadDirectory() {
+        std::vector<DirectoryEntry> directory;
+        BarrelDirectory::readAll(barrelDir + "/directory.bin", directory);
+        deltaBytes = DeltaPostings::validBytes(deltaPath);
+
+        // The first stored record tells whether the index was built with positions
+        for (uint32_t wid = 0; wid < directory.size(); ++wid) {
+            if (directory[wid].length == 0) continue;
+            std::ifstream in(barrelFile(directory[wid].barrel), std::ios::binary);
+            std::vector<char> buf(std::min<uint32_t>(directory[wid].length, 32));
+            in.seekg(directory[wid].offset);
+            if (!in.read(buf.data(), buf.size())) break;
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(buf.data());
+            PostingHeader h;
+            positional = PostingCodec::decodeHeader(p, p + buf.size(), h) && h.positional;
+            break;
+        }
+    }
+
+    void loadDocLengths() {
+        std::vector<uint32_t> all;
+        CollectionStats stats;
+        lengths = DocLengths::readAll(docLengthsPath, all, stats);
+        lengthCount = static_cast<uint32_t>(all.size());
+    }
+
+    bool fail(const std::string& why) {
+        std::cerr << "[Indexer][ERROR] " << why << "\n";
+        return false;
+    }
+
+    std::string barrelFile(uint32_t barrel) const {
+        return barrelDir + "/barrel_" + std::to_string(barrel) + ".bin";
     }
 
-    void appendLexicon() {
-        if (newlyAddedWords.empty()) return;
+    // Words stay pending until written, so a failed append is retried
+    bool appendLexicon() {
+        if (newlyAddedWords.empty()) return true;
         std::ofstream out(lexiconPath, std::ios::app);
         for (auto& [w, id] : newlyAddedWords)
             out << w << " " << id << "\n";
+        out.close();
+        if (!out) return false;
         newlyAddedWords.clear();
+        return true;
     }
 
 public:
@@ -86,64 +143,65 @@ public:
           lexiconPath(lexiconFile),
           forwardPath(forward),
           docMapPath(docmap),
-          barrelDir(barrels)
+          barrelDir(barrels),
+          docLengthsPath((fs::path(docmap).parent_path() / "doclens.bin").string()),
+          deltaPath(barrels + "/delta.bin")
     {
         fs::create_directories(barrelDir);
         loadLexicon();
+        loadDirectory();
+        loadDocLengths();
         loadDocCounters();
     }
 
     
+    // Index generation: changes whenever a document is added, so results
+    // computed at an older generation (e.g. cached ones) are stale
+    uint64_t generation() const { return generationCount.load(std::memory_order_acquire); }
+
     // MAIN ENTRY
+    // The document is tokenized first; then the dataset line, new lexicon
+    // words and the delta entry are written, and only then the doc map row
+    // that makes the document visible. Any failure fails the add.
     bool addDocument(json doc) {
         // ---------- ASSIGN ID ----------
         std::string docID = "new" + std::to_string(++nextNewID);
+        uint32_t internalId = ++nextInternalDocID;
         doc["id"] = docID;
 
-        // ---------- DATASET ----------
-        std::ofstream raw(datasetPath, std::ios::app | std::ios::binary);
-        long long offset = raw.tellp();
+        // The DOM is only kept to stamp the new ID; fields are read back from
+        // the serialized line with the same scanner the batch indexers use.
         std::string dump = doc.dump();
-        raw << dump << "\n";
-        long long length = dump.size();
-        raw.close();
-
-        // DOC MAP
-        std::ofstream map(docMapPath, std::ios::app);
-        map << ++nextInternalDocID << "|"
-            << docID << "|"
-            << offset << "|"
-            << length << "\n";
-        map.close();
+        enum { TITLE, ABSTRACT, SUBMITTER, AUTHORS_PARSED };
+        JsonRecord paper{ "title", "abstract", "submitter", "authors_parsed" };
+        if (!paper.scan(dump)) return false; // not an object
 
         // TOKEN COLLECTION
         std::unordered_map<unsigned int, unsigned int> freq;
         std::unordered_map<unsigned int, int> mask;
+        std::unordered_map<unsigned int, std::vector<uint32_t>> wordPositions;
 
-        auto get = [](const json& j){
-            return j.is_string() ? j.get<std::string>() : "";
-        };
+        // Positions run on within a field (submitter and author names form one
+        // field, as in ForwardIndex) and jump by FIELD_GAP between fields
+        uint32_t position = 0;
+        int currentField = 0;
 
         auto processField = [&](const std::string& src, int fieldMask) {
-            std::string t = src;
-            std::replace_if(t.begin(), t.end(),
-                [](char c){ return !std::isalnum(static_cast<unsigned char>(c)); }, ' ');
-
-            std::stringstream ss(t);
-            std::string w;
-
-            while (ss >> w) {
-                w = clean(w);
-                if (w.empty() || stopWords.count(w)) continue;
-
-                if (!lexicon.count(w)) {
+            if (fieldMask != currentField) {
+                position += PostingCodec::FIELD_GAP;
+                currentField = fieldMask;
+            }
+            for (std::string_view w : tokens.tokenize(src)) {
+                auto it = lexicon.find(w);
+                if (it == lexicon.end()) {
                     unsigned int id = ++nextWordID;
-                    lexicon[w] = id;
+                    it = lexicon.emplace(std::string(w), id).first;
                     newlyAddedWords.emplace_back(w, id);
                 }
 
-                unsigned int wid = lexicon[w];
+                unsigned int wid = it->second;
                 freq[wid]++;
+                wordPositions[wid].push_back(position++);
 
                 if (!mask.count(wid) || fieldMask > mask[wid])
                     mask[wid] = fieldMask;
@@ -151,56 +209,70 @@ public:
         };
 
         // FIELD PROCESSING
-        if (doc.contains("abstract"))
-            processField(get(doc["abstract"]), 0);
+        std::string text;
+        auto processJsonField = [&](std::string_view raw, int fieldMask) {
+            text.clear();
+            if (jsonfields::appendString(raw, text)) processField(text, fieldMask);
+        };
 
-        if (doc.contains("title"))
-            processField(get(doc["title"]), 1);
+        processJsonField(paper.raw(ABSTRACT), 0);
+        processJsonField(paper.raw(TITLE), 1);
 
-        if (doc.contains("submitter"))
-            processField(get(doc["submitter"]), 2);
+        // Submitter and author names, assembled as the batch indexers do
+        text.clear();
+        if (jsonfields::appendString(paper.raw(SUBMITTER), text)) text += " ";
+        jsonfields::appendAuthors(paper.raw(AUTHORS_PARSED), text);
+        processField(text, 2);
 
-        if (doc.contains("authors_parsed")) {
-            for (auto& a : doc["authors_parsed"]) {
-                if (a.is_array() && a.size() >= 2) {
-                    processField(get(a[0]), 2);
-                    processField(get(a[1]), 2);
-                }
-            }
-        }
+        // ---------- DATASET ----------
+        std::ofstream raw(datasetPath, std::ios::app | std::ios::binary);
+        long long offset = raw.tellp();
+        raw << dump << "\n";
+        long long length = dump.size();
+        raw.close();
+        if (!raw) return fail("Cannot append to the dataset " + datasetPath);
 
         // WRITE NEW WORDS
-        appendLexicon();
+        if (!appendLexicon()) return fail("Cannot append to the lexicon " + lexiconPath);
 
-        // FORWARD INDEX
-        std::ofstream fwd(forwardPath, std::ios::app);
-        fwd << docID << " : ";
+        // POSTINGS: one delta entry (see DeltaPostings.hpp); positions only if the index has them
+        std::vector<DeltaPostings::DocTerm> docTerms;
+        docTerms.reserve(freq.size());
         for (auto& [wid, c] : freq)
-            fwd << wid << "(" << c << "," << mask[wid] << ") ";
-        fwd << "\n";
-        fwd.close();
+            docTerms.push_back({ wid, c, mask[wid], positional ? wordPositions[wid].data() : nullptr });
+        std::sort(docTerms.begin(), docTerms.end(), [](auto& a, auto& b) { return a.wordID < b.wordID; });
+        if (!DeltaPostings::append(deltaPath, internalId, docTerms, deltaBytes))
+            return fail("Cannot append postings to " + deltaPath);
 
-        // BARRELS + IDX
-        for (auto& [wid, c] : freq) {
-            int b = wid % TOTAL_BARRELS;
-
-            std::string txtFile = barrelDir + "/barrel_" + std::to_string(b) + ".txt";
-            std::string idxFile = barrelDir + "/barrel_" + std::to_string(b) + ".idx";
-
-            std::ofstream txt(txtFile, std::ios::app);
-            if (!txt.is_open()) continue;
-
-            long long pos = txt.tellp();
-
-            txt << wid << " 0 : "
-                << docID << "(" << c << "," << mask[wid] << ")\n";
-            txt.close();
+        // DOC MAP
+        std::ofstream map(docMapPath, std::ios::app);
+        map << internalId << "|"
+            << docID << "|"
+            << offset << "|"
+            << length << "\n";
+        map.close();
+        if (!map) return fail("Cannot append to the doc map " + docMapPath);
+
+        // DOC LENGTH
+        if (lengths) {
+            uint32_t docLength = 0;
+            for (auto& [wid, c] : freq) docLength += c;
+            if (!DocLengths::update(docLengthsPath, internalId, docLength, lengthCount))
+                return fail("Cannot update the doc lengths " + docLengthsPath);
+        }
 
-            std::ofstream idx(idxFile, std::ios::app);
-            idx << wid << " " << pos << "\n";
-            idx.close();
+        // FORWARD INDEX
+        std::string line = std::to_string(internalId) + " : ";
+        for (auto& [wid, c] : freq) {
+            const uint32_t* pos = positional ? wordPositions[wid].data() : nullptr;
+            PostingCodec::appendText(line, wid, c, mask[wid], pos, pos ? c : 0);
         }
+        std::ofstream fwd(forwardPath, std::ios::app);
+        fwd << line << "\n";
+        fwd.close();
+        if (!fwd) return fail("Cannot append to the forward index " + forwardPath);
 
+        generationCount.fetch_add(1, std::memory_order_release);
         return true;
     }
 };
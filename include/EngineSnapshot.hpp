@@ -0,0 +1,295 @@
+#ifndef ENGINE_SNAPSHOT_HPP
+#define ENGINE_SNAPSHOT_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include "FlatTables.hpp"
+#include "MappedFile.hpp"
+
+// Engine snapshot: the serving state that is otherwise rebuilt from text
+// files at startup (lexicon, doc table and its ID index, autocomplete
+// prefixes), written as one image of flat tables. The server maps the image
+// and points its tables at the sections in place, so loading costs a
+// checksum pass, not a parse.
+//
+//   char magic[8] = "STSNAP\0\0" | u32 version | u32 sectionCount | u64 checksum | u64 payloadBytes
+//   sectionCount x { u32 id, u32 0, u64 offset, u64 size }   (offsets from file start)
+//   section bytes, each starting on an 8-byte boundary
+//
+// The checksum covers everything after the 32-byte header. The Sources
+// section records the size of every text file the image was built from; an
+// image whose sources have changed since (e.g. DynamicIndexer appended to
+// the lexicon) is rejected as stale. Barrels and directory.bin are already
+// mapped in place, so they are referenced, not copied.
+
+enum class SnapshotSection : uint32_t {
+    Sources = 1,
+    Lexicon = 2,
+    DocTable = 3,
+    AutocompletePrefixes = 4,
+    AutocompleteLists = 5,
+    DocIds = 6,
+    Spelling = 7,
+};
+
+namespace snapshot {
+
+constexpr char MAGIC[8] = { 'S', 'T', 'S', 'N', 'A', 'P', 0, 0 };
+constexpr uint32_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 32;
+constexpr size_t ENTRY_SIZE = 24;
+
+// Word-at-a-time 64-bit checksum, fed incrementally
+class Checksum {
+private:
+    uint64_t h = 0x243F6A8885A308D3ull;
+    uint64_t total = 0;
+    uint8_t tail[8] = {};
+    size_t tailLen = 0;
+
+    void mix(uint64_t w) {
+        h ^= w * 0x9E3779B97F4A7C15ull;
+        h = ((h << 27) | (h >> 37)) * 0xC2B2AE3D27D4EB4Full + 0x165667B19E3779F9ull;
+    }
+
+public:
+    void update(const uint8_t* p, size_t n) {
+        total += n;
+        while (n > 0 && tailLen > 0) {
+            tail[tailLen++] = *p++; --n;
+            if (tailLen == 8) { mix(flat::readU64(tail)); tailLen = 0; }
+        }
+        for (; n >= 8; p += 8, n -= 8) mix(flat::readU64(p));
+        while (n > 0) { tail[tailLen++] = *p++; --n; }
+    }
+
+    uint64_t value() const {
+        Checksum c = *this;
+        uint64_t w = 0;
+        std::memcpy(&w, c.tail, c.tailLen);
+        c.mix(w);
+        c.mix(total);
+        return c.h;
+    }
+};
+
+} // namespace snapshot
+
+// ===================== WRITER =====================
+
+class SnapshotWriter {
+private:
+    struct Pending {
+        uint32_t id;
+        const uint8_t* data;
+        size_t size;
+    };
+    std::vector<Pending> sections;
+    std::deque<std::vector<uint8_t>> ownedBuffers; // deque: push_back keeps earlier buffers in place
+    std::vector<std::pair<std::string, uint64_t>> sources;
+
+public:
+    // The bytes are not copied and must stay valid until write()
+    void add(SnapshotSection id, const uint8_t* data, size_t size) {
+        sections.push_back({ static_cast<uint32_t>(id), data, size });
+    }
+
+    void add(SnapshotSection id, std::vector<uint8_t>&& buf) {
+        ownedBuffers.push_back(std::move(buf));
+        add(id, ownedBuffers.back().data(), ownedBuffers.back().size());
+    }
+
+    // Records a text file the image is derived from, for staleness checks
+    void addSource(const std::string& path) {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(path, ec);
+        sources.push_back({ path, ec ? 0 : size });
+    }
+
+    // Writes to a temporary file and renames it over `path`, so a server
+    // starting concurrently never maps a half-written image.
+    bool write(const std::string& path) {
+        std::vector<uint8_t> src;
+        flat::putU32(src, static_cast<uint32_t>(sources.size()));
+        for (const auto& [p, size] : sources) {
+            flat::putU64(src, size);
+            flat::putU32(src, static_cast<uint32_t>(p.size()));
+            src.insert(src.end(), p.begin(), p.end());
+        }
+        std::vector<Pending> all = { { static_cast<uint32_t>(SnapshotSection::Sources), src.data(), src.size() } };
+        all.insert(all.end(), sections.begin(), sections.end());
+
+        // Section table
+        std::vector<uint8_t> table;
+        uint64_t offset = snapshot::HEADER_SIZE + all.size() * snapshot::ENTRY_SIZE;
+        for (const auto& s : all) {
+            offset = (offset + 7) & ~uint64_t(7);
+            flat::putU32(table, s.id);
+            flat::putU32(table, 0);
+            flat::putU64(table, offset);
+            flat::putU64(table, s.size);
+            offset += s.size;
+        }
+
+        std::string tmp = path + ".tmp";
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "[Snapshot][ERROR] Cannot write " << tmp << "\n";
+            return false;
+        }
+
+        // Header placeholder; checksum is patched in once the payload is written
+        std::vector<uint8_t> header(snapshot::MAGIC, snapshot::MAGIC + sizeof(snapshot::MAGIC));
+        flat::putU32(header, snapshot::VERSION);
+        flat::putU32(header, static_cast<uint32_t>(all.size()));
+        flat::putU64(header, 0);
+        flat::putU64(header, offset - snapshot::HEADER_SIZE);
+        out.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+        snapshot::Checksum sum;
+        uint64_t written = snapshot::HEADER_SIZE;
+        auto emit = [&](const uint8_t* p, size_t n) {
+            out.write(reinterpret_cast<const char*>(p), n);
+            sum.update(p, n);
+            written += n;
+        };
+        emit(table.data(), table.size());
+        static const uint8_t zeros[8] = {};
+        for (const auto& s : all) {
+            emit(zeros, ((written + 7) & ~uint64_t(7)) - written);
+            if (s.size > 0) emit(s.data, s.size);
+        }
+
+        uint64_t checksum = sum.value();
+        out.seekp(16);
+        out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        out.close();
+        if (!out) {
+            std::cerr << "[Snapshot][ERROR] Write failed: " << tmp << "\n";
+            return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) {
+            std::cerr << "[Snapshot][ERROR] Cannot replace " << path << ": " << ec.message() << "\n";
+            return false;
+        }
+        std::cout << "[Snapshot] Wrote " << path << " (" << all.size() << " sections, "
+                  << written / 1024 << " KB)\n";
+        return true;
+    }
+};
+
+// ===================== IMAGE =====================
+
+class SnapshotImage {
+private:
+    struct Section {
+        uint32_t id;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    MappedFile map;
+    std::vector<Section> sections;
+
+    bool sourcesCurrent() const {
+        const uint8_t* p;
+        size_t n;
+        if (!section(SnapshotSection::Sources, p, n) || n < 4) return false;
+        const uint8_t* end = p + n;
+        uint32_t count = flat::readU32(p);
+        p += 4;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (end - p < 12) return false;
+            uint64_t size = flat::readU64(p);
+            uint32_t len = flat::readU32(p + 8);
+            p += 12;
+            if (static_cast<size_t>(end - p) < len) return false;
+            std::string path(reinterpret_cast<const char*>(p), len);
+            p += len;
+            std::error_code ec;
+            uint64_t now = std::filesystem::file_size(path, ec);
+            if (ec || now != size) {
+                std::cout << "[Snapshot] Stale: " << path << " changed since the image was written\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    // Maps and validates an image. verify=false skips the checksum pass.
+    bool open(const std::string& path, bool verify = true) {
+        sections.clear();
+        if (!std::filesystem::exists(path) || !map.open(path)) {
+            std::cout << "[Snapshot] No image at " << path << "\n";
+            return false;
+        }
+        const uint8_t* base = map.data();
+        size_t size = map.size();
+        if (size < snapshot::HEADER_SIZE || std::memcmp(base, snapshot::MAGIC, sizeof(snapshot::MAGIC)) != 0 ||
+            flat::readU32(base + 8) != snapshot::VERSION ||
+            flat::readU64(base + 24) != size - snapshot::HEADER_SIZE) {
+            std::cerr << "[Snapshot][ERROR] " << path << " is not a valid version "
+                      << snapshot::VERSION << " image\n";
+            map.close();
+            return false;
+        }
+
+        if (verify) {
+            map.advise(MappedFile::Advice::Sequential);
+            snapshot::Checksum sum;
+            sum.update(base + snapshot::HEADER_SIZE, size - snapshot::HEADER_SIZE);
+            if (sum.value() != flat::readU64(base + 16)) {
+                std::cerr << "[Snapshot][ERROR] Checksum mismatch in " << path << "\n";
+                map.close();
+                return false;
+            }
+        }
+
+        uint32_t count = flat::readU32(base + 12);
+        if (snapshot::HEADER_SIZE + uint64_t(count) * snapshot::ENTRY_SIZE > size) {
+            map.close();
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint8_t* e = base + snapshot::HEADER_SIZE + i * snapshot::ENTRY_SIZE;
+            Section s{ flat::readU32(e), flat::readU64(e + 8), flat::readU64(e + 16) };
+            if (s.offset > size || s.size > size - s.offset) {
+                std::cerr << "[Snapshot][ERROR] Section " << s.id << " out of bounds in " << path << "\n";
+                sections.clear();
+                map.close();
+                return false;
+            }
+            sections.push_back(s);
+        }
+
+        if (!sourcesCurrent()) {
+            sections.clear();
+            map.close();
+            return false;
+        }
+        map.advise(MappedFile::Advice::Normal);
+        return true;
+    }
+
+    bool section(SnapshotSection id, const uint8_t*& data, size_t& size) const {
+        for (const auto& s : sections) {
+            if (s.id != static_cast<uint32_t>(id)) continue;
+            data = map.data() + s.offset;
+            size = static_cast<size_t>(s.size);
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif
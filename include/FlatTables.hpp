@@ -0,0 +1,226 @@
+#ifndef FLAT_TABLES_HPP
+#define FLAT_TABLES_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Immutable lookup tables stored in one contiguous little-endian buffer.
+// A table either owns its buffer (built from text files at startup) or views
+// bytes inside a memory-mapped engine snapshot; lookups are identical in both
+// cases and never need the buffer to be parsed first.
+
+namespace flat {
+
+inline uint32_t readU32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+inline uint64_t readU64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+inline void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    uint8_t b[sizeof(v)];
+    std::memcpy(b, &v, sizeof(v));
+    out.insert(out.end(), b, b + sizeof(v));
+}
+
+inline void putU64(std::vector<uint8_t>& out, uint64_t v) {
+    uint8_t b[sizeof(v)];
+    std::memcpy(b, &v, sizeof(v));
+    out.insert(out.end(), b, b + sizeof(v));
+}
+
+// FNV-1a: stable across platforms and runs, unlike std::hash
+inline uint64_t hash(std::string_view s) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+} // namespace flat
+
+// ===================== STRING TABLE =====================
+
+// String -> uint32 map with an open-addressing hash index.
+// Layout (u32 fields):
+//   count | slotCount | count x { keyOffset, keyLength, value } | slotCount x slot | key bytes
+// slot = entry index + 1 (0 = empty), linear probing. Entries keep build order.
+
+class StringTable {
+private:
+    std::vector<uint8_t> owned;
+    const uint8_t* base = nullptr;
+    size_t bytes = 0;
+    uint32_t count = 0;
+    uint32_t slotCount = 0;
+    const uint8_t* entries = nullptr;
+    const uint8_t* slots = nullptr;
+    const char* keys = nullptr;
+
+public:
+    StringTable() = default;
+    StringTable(const StringTable&) = delete;
+    StringTable& operator=(const StringTable&) = delete;
+    StringTable(StringTable&&) = default;            // the heap buffer, and so every
+    StringTable& operator=(StringTable&&) = default; // pointer into it, survives a move
+
+    static std::vector<uint8_t> build(const std::vector<std::pair<std::string, uint32_t>>& items) {
+        uint32_t n = static_cast<uint32_t>(items.size());
+        uint32_t nSlots = 1;
+        while (nSlots < n * 2 + 1) nSlots <<= 1; // load factor <= 0.5
+
+        std::vector<uint32_t> slotArr(nSlots, 0);
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t s = static_cast<uint32_t>(flat::hash(items[i].first)) & (nSlots - 1);
+            while (slotArr[s] != 0) s = (s + 1) & (nSlots - 1);
+            slotArr[s] = i + 1;
+        }
+
+        std::vector<uint8_t> out;
+        flat::putU32(out, n);
+        flat::putU32(out, nSlots);
+        uint32_t keyOffset = 0;
+        for (const auto& [k, v] : items) {
+            flat::putU32(out, keyOffset);
+            flat::putU32(out, static_cast<uint32_t>(k.size()));
+            flat::putU32(out, v);
+            keyOffset += static_cast<uint32_t>(k.size());
+        }
+        for (uint32_t s : slotArr) flat::putU32(out, s);
+        for (const auto& kv : items) out.insert(out.end(), kv.first.begin(), kv.first.end());
+        return out;
+    }
+
+    // Takes ownership of a buffer produced by build()
+    bool assign(std::vector<uint8_t>&& buf) {
+        owned = std::move(buf);
+        return attach(owned.data(), owned.size());
+    }
+
+    // Views an existing buffer (e.g. a snapshot section); it must outlive the table
+    bool attach(const uint8_t* p, size_t size) {
+        base = nullptr; bytes = 0; count = slotCount = 0;
+        if (size < 8) return false;
+        uint32_t n = flat::readU32(p), s = flat::readU32(p + 4);
+        uint64_t fixed = 8 + uint64_t(n) * 12 + uint64_t(s) * 4;
+        if (fixed > size || (s & (s - 1)) != 0 || (s == 0 && n > 0)) return false;
+        base = p; bytes = size; count = n; slotCount = s;
+        entries = p + 8;
+        slots = entries + uint64_t(n) * 12;
+        keys = reinterpret_cast<const char*>(slots + uint64_t(s) * 4);
+        return true;
+    }
+
+    size_t size() const { return count; }
+    const uint8_t* data() const { return base; }
+    size_t byteSize() const { return bytes; }
+
+    std::string_view key(size_t i) const {
+        const uint8_t* e = entries + i * 12;
+        return { keys + flat::readU32(e), flat::readU32(e + 4) };
+    }
+
+    uint32_t value(size_t i) const { return flat::readU32(entries + i * 12 + 8); }
+
+    bool find(std::string_view k, uint32_t& v) const {
+        if (slotCount == 0) return false;
+        uint32_t s = static_cast<uint32_t>(flat::hash(k)) & (slotCount - 1);
+        for (uint32_t probe = 0; probe < slotCount; ++probe) {
+            uint32_t idx = flat::readU32(slots + uint64_t(s) * 4);
+            if (idx == 0) return false;
+            if (key(idx - 1) == k) {
+                v = value(idx - 1);
+                return true;
+            }
+            s = (s + 1) & (slotCount - 1);
+        }
+        return false;
+    }
+
+    bool contains(std::string_view k) const {
+        uint32_t v;
+        return find(k, v);
+    }
+};
+
+// ===================== DOC TABLE =====================
+
+struct DocMetadata {
+    std::string externalId;
+    long long offset = 0;
+    long long length = 0;
+};
+
+// Internal doc ID -> (original ID, raw dataset offset, length).
+// Layout: u32 count | u32 0 | count x { u64 offset, u32 length, u32 idOffset, u32 idLength, u32 0 } | id bytes
+// Rows with idLength == 0 are unused internal IDs.
+
+class DocTable {
+private:
+    static constexpr size_t ROW = 24;
+
+    std::vector<uint8_t> owned;
+    const uint8_t* base = nullptr;
+    size_t bytes = 0;
+    uint32_t count = 0;
+    const uint8_t* rows = nullptr;
+    const char* ids = nullptr;
+
+public:
+    DocTable() = default;
+    DocTable(const DocTable&) = delete;
+    DocTable& operator=(const DocTable&) = delete;
+    DocTable(DocTable&&) = default;
+    DocTable& operator=(DocTable&&) = default;
+
+    static std::vector<uint8_t> build(const std::vector<DocMetadata>& docs) {
+        std::vector<uint8_t> out;
+        flat::putU32(out, static_cast<uint32_t>(docs.size()));
+        flat::putU32(out, 0);
+        uint32_t idOffset = 0;
+        for (const auto& d : docs) {
+            flat::putU64(out, static_cast<uint64_t>(d.offset));
+            flat::putU32(out, static_cast<uint32_t>(d.length));
+            flat::putU32(out, idOffset);
+            flat::putU32(out, static_cast<uint32_t>(d.externalId.size()));
+            flat::putU32(out, 0);
+            idOffset += static_cast<uint32_t>(d.externalId.size());
+        }
+        for (const auto& d : docs) out.insert(out.end(), d.externalId.begin(), d.externalId.end());
+        return out;
+    }
+
+    bool assign(std::vector<uint8_t>&& buf) {
+        owned = std::move(buf);
+        return attach(owned.data(), owned.size());
+    }
+
+    bool attach(const uint8_t* p, size_t size) {
+        base = nullptr; bytes = 0; count = 0;
+        if (size < 8) return false;
+        uint32_t n = flat::readU32(p);
+        if (8 + uint64_t(n) * ROW > size) return false;
+        base = p; bytes = size; count = n;
+        rows = p + 8;
+        ids = reinterpret_cast<const char*>(rows + uint64_t(n) * ROW);
+        return true;
+    }
+
+    size_t size() const { return count; }
+    const uint8_t* data() const { return base; }
+    size_t byteSize() const { return bytes; }
+
+    bool has(uint32_t doc) const { return doc < count && flat::readU32(rows + doc * ROW + 16) > 0; }
+    uint64_t offset(uint32_t doc) const { return flat::readU64(rows + doc * ROW); }
+    uint32_t length(uint32_t doc) const { return flat::readU32(rows + doc * ROW + 8); }
+
+    std::string_view externalId(uint32_t doc) const {
+        const uint8_t* r = rows + doc * ROW;
+        return { ids + flat::readU32(r + 12), flat::readU32(r + 16) };
+    }
+};
+
+#endif
@@ -1,35 +1,51 @@
 #ifndef Forwardindex_HPP
 #define Forwardindex_HPP
 
-#include <json.hpp>
+#include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <unordered_map>
 #include <unordered_set>
-#include <list>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
 #include <sstream>
-#include <locale>
 #include <algorithm>
-
-using json = nlohmann::json;
+#include "BoundedQueue.hpp"
+#include "JsonFields.hpp"
+#include "Tokenizer.hpp"
+#include "PostingCodec.hpp"
 
 class ForwardIndex {
+    static constexpr size_t BATCH_SIZE = 256;   // lines per pipeline batch
+    static constexpr size_t QUEUE_DEPTH = 16;   // batches in flight per worker queue
+
+    // Unit of work passed reader -> worker -> writer
+    struct Batch {
+        unsigned int firstId = 0;        // internal doc ID of lines[0]
+        std::vector<std::string> lines;  // raw dataset lines (reader -> worker)
+        std::string text;                // formatted forward index lines (worker -> writer)
+        size_t bytes = 0;                // raw input bytes, for throughput
+        size_t docs = 0;                 // documents written
+        bool last = false;               // end-of-stream marker
+    };
+
     std::string path_lexicon;
     std::string path_dataset;
-    std::locale current_locale;
+    std::string outputPath;
+    unsigned int threads;
+    bool positional; // also record word positions (see PostingCodec.hpp)
 
-    std::unordered_map<std::string, unsigned int> words;
-    std::unordered_map<std::string, std::list<unsigned int>> f_index;
-
-    std::unordered_set<std::string> stopWords = {
-        "the","and","is","in","at","of","on","for","to","a","an","that","it"
-    };
+    std::unordered_map<std::string, unsigned int, tokenizer::StringHash, std::equal_to<>> words;
 
 public:
-    ForwardIndex(std::string p_lexicon, std::string p_dataset)
-        : path_lexicon(p_lexicon), path_dataset(p_dataset) {
-        try { current_locale = std::locale(""); }
-        catch (...) { current_locale = std::locale::classic(); }
-    }
+    // nThreads = number of parse/tokenize workers (0 = hardware concurrency)
+    ForwardIndex(std::string p_lexicon, std::string p_dataset,
+                 std::string p_output = "ForwardIndextest.txt", unsigned int nThreads = 0,
+                 bool withPositions = false)
+        : path_lexicon(p_lexicon), path_dataset(p_dataset),
+          outputPath(p_output), threads(nThreads), positional(withPositions) {}
 
     void lexiconCreater() {
         std::ifstream ifs(path_lexicon);
@@ -46,93 +62,45 @@ public:
         ifs.close();
     }
 
-    std::string cleanWord(const std::string& w) {
-        std::string r;
-        for (char c : w)
-            if (std::isalpha(c, current_locale))
-                r += std::tolower(c, current_locale);
-        return r;
-    }
-
-   void forwardIndex_creator() {
-    lexiconCreater();
-
-    std::ifstream file(path_dataset);
-    if (!file.is_open()) return;
-
-    std::string line;
-    unsigned int uncounted = 0;
-
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
-
-        std::string id = "";
+    // Formats one dataset line as "internalId : wid(count,mask[;positions]) ... \n" and
+    // appends it to `out`. Returns false for lines that are not valid records.
+    // Only reads shared state, so any number of workers can call it at once.
+    bool processDocument(const std::string& line, unsigned int internalId, std::string& out) const {
         std::string title_s, abstract_s, authors_s;
 
-        try {
-            json paper = json::parse(line);
-
-            // Lambda function to safely get string from json
-            // Explanation: This is a small function defined inline.
-            // It takes a json object and returns the string if it exists, otherwise empty string.
-            auto get = [](const json& j){ return j.is_string() ? j.get<std::string>() : ""; };
-
-            if (paper.contains("id"))
-                id = get(paper["id"]); // use lambda to get id string
-            else
-                id = "Unassigned" + std::to_string(++uncounted);
-
-            if (paper.contains("title"))
-                title_s = get(paper["title"]) + " ";
-
-            if (paper.contains("abstract"))
-                abstract_s = get(paper["abstract"]) + " ";
+        // Fields are scanned in place; no DOM is built for the record
+        enum { TITLE, ABSTRACT, SUBMITTER, AUTHORS_PARSED };
+        thread_local JsonRecord paper{ "title", "abstract", "submitter", "authors_parsed" };
+        if (!paper.scan(line)) return false;
 
-            if (paper.contains("submitter"))
-                authors_s += get(paper["submitter"]) + " ";
+        if (paper.has(TITLE)) { paper.appendString(TITLE, title_s); title_s += " "; }
+        if (paper.has(ABSTRACT)) { paper.appendString(ABSTRACT, abstract_s); abstract_s += " "; }
+        if (paper.has(SUBMITTER)) { paper.appendString(SUBMITTER, authors_s); authors_s += " "; }
 
-            if (paper.contains("authors_parsed") && paper["authors_parsed"].is_array()) {
-                for (const auto& a : paper["authors_parsed"]) {
-                    if (a.is_array() && a.size() >= 2) {
-                        authors_s += get(a[1]) + " ";
-                        authors_s += get(a[0]) + " ";
-                        if (a.size() >= 3)
-                            authors_s += get(a[2]) + " ";
-                    }
-                }
-            }
-
-        } catch (...) {
-            continue;
-        }
+        jsonfields::appendAuthors(paper.raw(AUTHORS_PARSED), authors_s);
 
         // Maps for frequency and mask
         std::unordered_map<unsigned int, unsigned int> freq;
         std::unordered_map<unsigned int, int> mask;
+        std::unordered_map<unsigned int, std::vector<uint32_t>> positions;
+        uint32_t fieldStart = 0;
 
         // Lambda function to process text fields (abstract, title, authors)
         // Explanation: This is an inline function taking text and a mask value.
-        // It cleans the text, splits into words, checks stop words, and updates frequency and mask.
+        // It tokenizes the text (stop words dropped) and updates frequency and mask.
+        thread_local Tokenizer tokens;
         auto process_field = [&](const std::string& text, int fieldMask) {
-            std::string cleanedText = text;
-            for (char& c : cleanedText)
-                if (!std::isalnum(c, current_locale))
-                    c = ' ';
-
-            std::istringstream iss(cleanedText);
-            std::string w;
-            while (iss >> w) {
-                std::string cleaned = cleanWord(w);
-                if (cleaned.empty()) continue;
-                if (stopWords.count(cleaned)) continue;
-
-                auto it = words.find(cleaned);
+            const auto& toks = tokens.tokenize(text);
+            for (size_t i = 0; i < toks.size(); ++i) {
+                auto it = words.find(toks[i]);
                 if (it != words.end()) {
                     unsigned int wid = it->second;
                     freq[wid]++;           // count
                     mask[wid] = fieldMask; // field mask
+                    if (positional) positions[wid].push_back(fieldStart + static_cast<uint32_t>(i));
                 }
             }
+            fieldStart += static_cast<uint32_t>(toks.size()) + PostingCodec::FIELD_GAP;
         };
 
         // process fields: abstract=0, title=1, author=2
@@ -140,28 +108,124 @@ public:
         process_field(title_s,    1);
         process_field(authors_s,  2);
 
-        // store only unique word IDs in f_index
-        std::list<unsigned int> ids;
-        for (auto& kv : freq)
-            ids.push_back(kv.first);
-        f_index.emplace(id, ids);
-
-        // write to file in required format
-        std:: string outputfile = "ForwardIndextest.txt";
-        std::ofstream out("ForwardIndextest.txt", std::ios::app);
-        out << id << " : ";
+        // write in required format
+        out += std::to_string(internalId);
+        out += " : ";
         for (auto& kv : freq) {
-            unsigned int wid = kv.first;
-            unsigned int count = kv.second;
-            int m = mask[wid];
-            out << wid << "(" << count << "," << m << ") ";
+            const uint32_t* pos = positional ? positions[kv.first].data() : nullptr;
+            PostingCodec::appendText(out, kv.first, kv.second, mask[kv.first], pos, pos ? kv.second : 0);
         }
-        out << "\n";
-        out.close();
+        out += '\n';
+        return true;
     }
-}
 
+    // Pipelined build: one reader thread hands batches of lines round-robin to
+    // N workers over SPSC queues; this thread collects the formatted batches in
+    // the same round-robin order, so output order matches input order, and
+    // writes them through a single buffered stream.
+    void forwardIndex_creator() {
+        lexiconCreater();
+
+        std::ifstream file(path_dataset, std::ios::binary);
+        if (!file.is_open()) return;
 
+        std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "[Forward][ERROR] Cannot open output file: " << outputPath << "\n";
+            return;
+        }
+
+        unsigned int n = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::unique_ptr<SpscQueue<Batch>>> inQueues, outQueues;
+        for (unsigned int i = 0; i < n; ++i) {
+            inQueues.push_back(std::make_unique<SpscQueue<Batch>>(QUEUE_DEPTH));
+            outQueues.push_back(std::make_unique<SpscQueue<Batch>>(QUEUE_DEPTH));
+        }
+
+        // READER: internal doc IDs are 1-based line numbers, the same ones AUC writes to the doc map
+        std::thread reader([&] {
+            unsigned int internalId = 0;
+            size_t target = 0;
+            Batch batch;
+            std::string line;
+            while (std::getline(file, line)) {
+                if (batch.lines.empty()) batch.firstId = internalId + 1;
+                ++internalId;
+                batch.bytes += line.size() + 1;
+                batch.lines.push_back(std::move(line));
+                if (batch.lines.size() == BATCH_SIZE) {
+                    inQueues[target]->push(std::move(batch));
+                    batch = Batch{};
+                    target = (target + 1) % n;
+                }
+            }
+            if (!batch.lines.empty()) {
+                inQueues[target]->push(std::move(batch));
+                target = (target + 1) % n;
+            }
+            // One end marker per worker, continuing the round-robin
+            for (unsigned int i = 0; i < n; ++i) {
+                Batch end;
+                end.last = true;
+                inQueues[(target + i) % n]->push(std::move(end));
+            }
+        });
+
+        // WORKERS: parse + tokenize + format
+        std::vector<std::thread> workers;
+        for (unsigned int w = 0; w < n; ++w) {
+            workers.emplace_back([&, w] {
+                Batch batch;
+                do {
+                    inQueues[w]->pop(batch);
+                    for (size_t i = 0; i < batch.lines.size(); ++i) {
+                        if (batch.lines[i].empty()) continue;
+                        if (processDocument(batch.lines[i], batch.firstId + static_cast<unsigned int>(i), batch.text))
+                            ++batch.docs;
+                    }
+                    batch.lines.clear();
+                    bool last = batch.last;
+                    outQueues[w]->push(std::move(batch));
+                    if (last) break;
+                    batch = Batch{};
+                } while (true);
+            });
+        }
+
+        // WRITER: this thread, in input order
+        auto start = std::chrono::steady_clock::now();
+        auto lastReport = start;
+        size_t docs = 0, bytes = 0;
+        auto report = [&](auto now, const char* end) {
+            double secs = std::chrono::duration<double>(now - start).count();
+            if (secs <= 0) secs = 1e-9;
+            std::ostringstream mbps;
+            mbps << std::fixed << std::setprecision(1) << bytes / secs / (1024.0 * 1024.0);
+            std::cout << "\r[Forward] " << docs << " docs, "
+                      << static_cast<long long>(docs / secs) << " docs/s, "
+                      << mbps.str() << " MB/s" << end << std::flush;
+        };
+
+        Batch batch;
+        for (size_t next = 0; ; next = (next + 1) % n) {
+            outQueues[next]->pop(batch);
+            if (batch.last) break;
+            out.write(batch.text.data(), batch.text.size());
+            docs += batch.docs;
+            bytes += batch.bytes;
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReport >= std::chrono::seconds(1)) {
+                report(now, "");
+                lastReport = now;
+            }
+        }
+
+        reader.join();
+        for (auto& t : workers) t.join();
+        out.close();
+        report(std::chrono::steady_clock::now(), "\n");
+    }
 };
 
 #endif
@@ -0,0 +1,348 @@
+#ifndef HNSW_HPP
+#define HNSW_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "MappedFile.hpp"
+#include "VectorMath.hpp"
+
+// Rows of a unit-vector matrix the graph is built over: node n is row
+// rows[n], or row n without an indirection. The matrix belongs to the caller
+// and must outlive the index.
+struct VectorView {
+    const float* base = nullptr;
+    size_t dim = 0;
+    const uint32_t* rows = nullptr;
+
+    const float* at(uint32_t n) const { return base + size_t(rows ? rows[n] : n) * dim; }
+};
+
+// Hierarchical navigable small world graph (Malkov & Yashunin) for
+// approximate maximum inner product search over unit vectors, i.e. cosine.
+//
+// Every node sits on layer 0 and, with probability 1/M per layer, on the
+// layers above; a search descends greedily from the top entry point and then
+// explores layer 0 with a beam of `ef` candidates. A new node links to M
+// neighbours chosen with the paper's diversity heuristic; lists that fill up
+// (M links, 2M on layer 0) are re-selected the same way.
+// Layer-0 lists are one flat array of (count, 2M slots) per node.
+//
+// Nodes are inserted in order with a fixed seed, so a build is reproducible.
+// search() is const and may run from several threads at once.
+//
+// A build costs thousands of dot products per node, so the graph can be
+// saved and loaded; the caller's fingerprint of the vectors it was built
+// over must match on load.
+//
+//   char magic[8] = "STHNSW\0\0" | u32 version | u32 count | u32 dim | u32 M
+//   u32 entry | i32 maxLayer | u64 fingerprint
+//   count x u8 topLayer (zero-padded to 4 bytes)
+//   count x (1 + 2M) u32 layer-0 lists
+//   per node with topLayer > 0, in order: topLayer x (1 + M) u32
+
+class HnswIndex {
+public:
+    struct Params {
+        uint32_t M = 16;
+        uint32_t efConstruction = 100;
+        uint32_t seed = 42;
+    };
+
+    using Hit = std::pair<float, uint32_t>; // similarity, node
+
+private:
+    static constexpr char MAGIC[8] = { 'S', 'T', 'H', 'N', 'S', 'W', 0, 0 };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 40;
+
+    VectorView vecs;
+    uint32_t count = 0;
+    uint32_t M = 16, M0 = 32;
+    uint32_t efConstruction = 100;
+    std::vector<uint32_t> level0;              // count x (1 + M0)
+    std::vector<uint8_t> topLayer;             // highest layer of each node
+    std::vector<std::vector<uint32_t>> upper;  // per node: topLayer x (1 + M), layers 1..top
+    uint32_t entry = 0;
+    int maxLayer = -1;
+
+    struct Closer { bool operator()(const Hit& a, const Hit& b) const { return a.first < b.first; } };
+    struct Farther { bool operator()(const Hit& a, const Hit& b) const { return a.first > b.first; } };
+
+    float sim(const float* q, uint32_t n) const { return vecmath::dot(q, vecs.at(n), vecs.dim); }
+
+    uint32_t* links(uint32_t n, int layer) {
+        return layer == 0 ? &level0[size_t(n) * (1 + M0)] : &upper[n][size_t(layer - 1) * (1 + M)];
+    }
+    const uint32_t* links(uint32_t n, int layer) const {
+        return layer == 0 ? &level0[size_t(n) * (1 + M0)] : &upper[n][size_t(layer - 1) * (1 + M)];
+    }
+
+    // Per-thread visited marks; a new epoch clears them all at once
+    struct Visited {
+        std::vector<uint32_t> mark;
+        uint32_t epoch = 0;
+
+        void reset(size_t n) {
+            if (mark.size() < n) mark.resize(n, 0);
+            if (++epoch == 0) {
+                std::fill(mark.begin(), mark.end(), 0);
+                epoch = 1;
+            }
+        }
+        bool visit(uint32_t n) {
+            if (mark[n] == epoch) return false;
+            mark[n] = epoch;
+            return true;
+        }
+    };
+
+    static Visited& visited() {
+        thread_local Visited v;
+        return v;
+    }
+
+    uint32_t greedy(const float* q, uint32_t from, int layer) const {
+        uint32_t cur = from;
+        float best = sim(q, cur);
+        for (bool moved = true; moved; ) {
+            moved = false;
+            const uint32_t* l = links(cur, layer);
+            for (uint32_t k = 1; k <= l[0]; ++k) {
+                float s = sim(q, l[k]);
+                if (s > best) { best = s; cur = l[k]; moved = true; }
+            }
+        }
+        return cur;
+    }
+
+    // Beam search of one layer; the ef most similar nodes found, unordered
+    std::vector<Hit> searchLayer(const float* q, uint32_t from, size_t ef, int layer) const {
+        Visited& seen = visited();
+        seen.reset(count);
+        std::priority_queue<Hit, std::vector<Hit>, Closer> frontier;  // best first
+        std::priority_queue<Hit, std::vector<Hit>, Farther> found;    // worst on top
+        Hit start{ sim(q, from), from };
+        seen.visit(from);
+        frontier.push(start);
+        found.push(start);
+        while (!frontier.empty()) {
+            Hit c = frontier.top();
+            if (found.size() >= ef && c.first < found.top().first) break;
+            frontier.pop();
+            const uint32_t* l = links(c.second, layer);
+            for (uint32_t k = 1; k <= l[0]; ++k) {
+                uint32_t n = l[k];
+                if (!seen.visit(n)) continue;
+                float s = sim(q, n);
+                if (found.size() < ef || s > found.top().first) {
+                    frontier.push({ s, n });
+                    found.push({ s, n });
+                    if (found.size() > ef) found.pop();
+                }
+            }
+        }
+        std::vector<Hit> out;
+        out.reserve(found.size());
+        for (; !found.empty(); found.pop()) out.push_back(found.top());
+        return out;
+    }
+
+    // Keeps up to m candidates, most similar first, skipping any that is
+    // closer to an already kept neighbour than to the base node
+    std::vector<uint32_t> selectNeighbors(std::vector<Hit> cand, size_t m) const {
+        std::sort(cand.begin(), cand.end(), [](const Hit& a, const Hit& b) { return a.first > b.first; });
+        std::vector<uint32_t> kept;
+        for (const Hit& c : cand) {
+            if (kept.size() >= m) break;
+            const float* v = vecs.at(c.second);
+            bool diverse = true;
+            for (uint32_t r : kept)
+                if (sim(v, r) > c.first) { diverse = false; break; }
+            if (diverse) kept.push_back(c.second);
+        }
+        return kept;
+    }
+
+    void link(uint32_t from, uint32_t to, int layer) {
+        uint32_t cap = layer == 0 ? M0 : M;
+        uint32_t* l = links(from, layer);
+        if (l[0] < cap) {
+            l[++l[0]] = to;
+            return;
+        }
+        // Full: re-select among the old links plus the new one
+        const float* v = vecs.at(from);
+        std::vector<Hit> cand;
+        cand.reserve(cap + 1);
+        for (uint32_t k = 1; k <= l[0]; ++k) cand.push_back({ sim(v, l[k]), l[k] });
+        cand.push_back({ sim(v, to), to });
+        std::vector<uint32_t> kept = selectNeighbors(std::move(cand), cap);
+        l[0] = static_cast<uint32_t>(kept.size());
+        std::copy(kept.begin(), kept.end(), l + 1);
+    }
+
+    void insert(uint32_t n, int layer) {
+        const float* q = vecs.at(n);
+        uint32_t cur = entry;
+        for (int l = maxLayer; l > layer; --l) cur = greedy(q, cur, l);
+        for (int l = std::min(layer, maxLayer); l >= 0; --l) {
+            std::vector<Hit> cand = searchLayer(q, cur, efConstruction, l);
+            cur = std::max_element(cand.begin(), cand.end())->second;
+            for (uint32_t m : selectNeighbors(std::move(cand), M)) {
+                uint32_t* own = links(n, l);
+                own[++own[0]] = m;
+                link(m, n, l);
+            }
+        }
+        if (layer > maxLayer) {
+            maxLayer = layer;
+            entry = n;
+        }
+    }
+
+public:
+    static constexpr size_t DEFAULT_EF = 64;
+
+    // Builds the graph over nodes 0..n-1 of `v`
+    void build(const VectorView& v, uint32_t n) { build(v, n, Params{}); }
+
+    void build(const VectorView& v, uint32_t n, const Params& p) {
+        vecs = v;
+        count = n;
+        M = std::max<uint32_t>(p.M, 2);
+        M0 = 2 * M;
+        efConstruction = std::max(p.efConstruction, M);
+        level0.assign(size_t(n) * (1 + M0), 0);
+        topLayer.assign(n, 0);
+        upper.assign(n, {});
+        maxLayer = -1;
+        entry = 0;
+
+        std::mt19937 rng(p.seed);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        double mult = 1.0 / std::log(double(M));
+        for (uint32_t i = 0; i < n; ++i) {
+            int layer = std::min(static_cast<int>(-std::log(1.0 - unit(rng)) * mult), 255);
+            topLayer[i] = static_cast<uint8_t>(layer);
+            if (layer > 0) upper[i].assign(size_t(layer) * (1 + M), 0);
+            if (maxLayer < 0) {
+                maxLayer = layer;
+                entry = i;
+            } else {
+                insert(i, layer);
+            }
+        }
+    }
+
+    bool save(const std::string& path, uint64_t fingerprint) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        uint32_t head[7] = { VERSION, count, static_cast<uint32_t>(vecs.dim), M, entry,
+                             static_cast<uint32_t>(maxLayer), 0 };
+        out.write(MAGIC, sizeof(MAGIC));
+        out.write(reinterpret_cast<const char*>(head), 6 * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+        out.write(reinterpret_cast<const char*>(topLayer.data()), topLayer.size());
+        out.write(reinterpret_cast<const char*>(head + 6), (4 - count % 4) % 4);
+        out.write(reinterpret_cast<const char*>(level0.data()), level0.size() * sizeof(uint32_t));
+        for (const auto& u : upper)
+            out.write(reinterpret_cast<const char*>(u.data()), u.size() * sizeof(uint32_t));
+        return static_cast<bool>(out);
+    }
+
+    // False (and the index left empty) unless the file holds a graph over n
+    // nodes of v's width with the same fingerprint
+    bool load(const std::string& path, const VectorView& v, uint32_t n, uint64_t fingerprint) {
+        *this = HnswIndex();
+        MappedFile map;
+        if (!map.open(path) || map.size() < HEADER_SIZE || std::memcmp(map.data(), MAGIC, sizeof(MAGIC)) != 0)
+            return false;
+        const uint8_t* p = map.data();
+        uint32_t head[6];
+        uint64_t fp;
+        std::memcpy(head, p + 8, sizeof(head));
+        std::memcpy(&fp, p + 32, sizeof(fp));
+        uint32_t m = head[3];
+        if (head[0] != VERSION || head[1] != n || head[2] != v.dim || fp != fingerprint || m < 2 || n == 0 ||
+            head[4] >= n || static_cast<int>(head[5]) < 0)
+            return false;
+
+        size_t pos = HEADER_SIZE, layers = (size_t(n) + 3) / 4 * 4;
+        size_t zero = size_t(n) * (1 + 2 * m) * sizeof(uint32_t);
+        if (map.size() < pos + layers + zero) return false;
+        topLayer.assign(p + pos, p + pos + n);
+        pos += layers;
+        level0.resize(zero / sizeof(uint32_t));
+        std::memcpy(level0.data(), p + pos, zero);
+        pos += zero;
+        upper.assign(n, {});
+        for (uint32_t i = 0; i < n; ++i) {
+            if (topLayer[i] == 0) continue;
+            size_t bytes = size_t(topLayer[i]) * (1 + m) * sizeof(uint32_t);
+            if (map.size() < pos + bytes) {
+                *this = HnswIndex();
+                return false;
+            }
+            upper[i].resize(bytes / sizeof(uint32_t));
+            std::memcpy(upper[i].data(), p + pos, bytes);
+            pos += bytes;
+        }
+
+        // Every list must fit its layer and point at existing nodes
+        auto valid = [&](const uint32_t* l, uint32_t cap) {
+            if (l[0] > cap) return false;
+            for (uint32_t k = 1; k <= l[0]; ++k)
+                if (l[k] >= n) return false;
+            return true;
+        };
+        bool ok = topLayer[head[4]] == head[5];
+        for (uint32_t i = 0; ok && i < n; ++i) {
+            ok = valid(&level0[size_t(i) * (1 + 2 * m)], 2 * m);
+            for (uint32_t l = 0; ok && l < topLayer[i]; ++l) ok = valid(&upper[i][size_t(l) * (1 + m)], m);
+        }
+        if (!ok) {
+            *this = HnswIndex();
+            return false;
+        }
+        vecs = v;
+        count = n;
+        M = m;
+        M0 = 2 * m;
+        entry = head[4];
+        maxLayer = static_cast<int>(head[5]);
+        return true;
+    }
+
+    bool empty() const { return count == 0; }
+    uint32_t size() const { return count; }
+
+    size_t byteSize() const {
+        size_t b = level0.size() * sizeof(uint32_t) + topLayer.size();
+        for (const auto& u : upper) b += u.size() * sizeof(uint32_t);
+        return b;
+    }
+
+    // The k nodes most similar to the unit vector q, most similar first;
+    // a wider ef finds them more reliably at the cost of more dot products
+    std::vector<Hit> search(const float* q, size_t k, size_t ef = DEFAULT_EF) const {
+        if (count == 0 || k == 0) return {};
+        uint32_t cur = entry;
+        for (int l = maxLayer; l > 0; --l) cur = greedy(q, cur, l);
+        std::vector<Hit> hits = searchLayer(q, cur, std::max(ef, k), 0);
+        std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+        if (hits.size() > k) hits.resize(k);
+        return hits;
+    }
+};
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef INDEX_BUILDER_HPP
+#define INDEX_BUILDER_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <filesystem>
+#include "PostingCodec.hpp"
+#include "barrels.hpp"
+#include "SpimiInverter.hpp"
+#include "JsonFields.hpp"
+#include "Tokenizer.hpp"
+#include "DocStore.hpp"
+#include "DocLengths.hpp"
+#include "Ranking.hpp"
+
+// IndexBuilder runs the whole indexing pipeline in one pass over the JSONL
+// dataset: it assigns word IDs (first occurrence, same order as Lexicon) and
+// internal doc IDs (line numbers, same as AUC) as it goes, inverts postings in
+// memory-budgeted SPIMI runs and writes the lexicon, doc map and barrels
+// directly, plus the doc store that results are served from and the length
+// column BM25 normalizes with. Barrel records carry BM25 impacts. No forward
+// or inverted index text files are produced.
+//
+// Output layout under outputDir:
+//   Lexicon/Lexicon (<dataset stem>).txt
+//   AUC.csv
+//   docs.bin
+//   doclens.bin
+//   Barrels/barrel_N.bin, directory.bin (word ID -> record) and routing.txt
+
+class IndexBuilder {
+private:
+    std::string datasetPath;
+    std::string outputDir;
+    bool positional; // also store word positions in the barrels
+
+    std::unordered_map<std::string, unsigned int, tokenizer::StringHash, std::equal_to<>> words;
+    std::vector<std::string> wordsById{ "" }; // wordID -> word (IDs start at 1)
+    SpimiInverter inverter;
+    unsigned int totalDocs = 0;
+    std::vector<uint32_t> docLengths{ 0 }; // tokens per internal doc ID
+    CollectionStats lengthStats;
+
+    // One tokenizer per field: all three token lists are alive at once
+    Tokenizer titleTokens, abstractTokens, authorTokens;
+
+    unsigned int wordIdFor(std::string_view w) {
+        auto it = words.find(w);
+        if (it != words.end()) return it->second;
+        unsigned int id = static_cast<unsigned int>(wordsById.size());
+        words.emplace(std::string(w), id);
+        wordsById.emplace_back(w);
+        return id;
+    }
+
+    enum Field { ID, TITLE, ABSTRACT, SUBMITTER, AUTHORS_PARSED };
+    JsonRecord paper{ "id", "title", "abstract", "submitter", "authors_parsed" };
+
+    // Parses one record and adds its postings; returns false for unusable
+    // lines, including a missing or malformed id. Other malformed string
+    // fields index as empty.
+    bool indexDocument(const std::string& line, uint32_t docId, std::string& originalId) {
+        std::string title_s, abstract_s, authors_s;
+        if (!paper.scan(line) || !paper.appendString(ID, originalId)) return false;
+        paper.appendString(TITLE, title_s);
+        paper.appendString(ABSTRACT, abstract_s);
+        if (paper.appendString(SUBMITTER, authors_s)) authors_s += " ";
+        jsonfields::appendAuthors(paper.raw(AUTHORS_PARSED), authors_s);
+
+        const auto& titleTok = titleTokens.tokenize(title_s);
+        const auto& abstractTok = abstractTokens.tokenize(abstract_s);
+        const auto& authorTok = authorTokens.tokenize(authors_s);
+
+        // Word IDs are assigned in Lexicon's field order: title, abstract, authors
+        std::unordered_map<unsigned int, std::pair<unsigned int, int>> freq; // wid -> (tf, mask)
+        for (auto* field : { &titleTok, &abstractTok, &authorTok })
+            for (std::string_view w : *field) freq.try_emplace(wordIdFor(w), 0u, 0);
+
+        // Masks follow ForwardIndex: abstract=0, title=1, author=2, last field wins.
+        // Positions are numbered in the same field order.
+        std::unordered_map<unsigned int, std::vector<uint32_t>> positions;
+        uint32_t fieldStart = 0;
+        auto count = [&](const std::vector<std::string_view>& toks, int fieldMask) {
+            for (size_t i = 0; i < toks.size(); ++i) {
+                unsigned int wid = words.find(toks[i])->second;
+                auto& e = freq[wid];
+                e.first++;
+                e.second = fieldMask;
+                if (positional) positions[wid].push_back(fieldStart + static_cast<uint32_t>(i));
+            }
+            fieldStart += static_cast<uint32_t>(toks.size()) + PostingCodec::FIELD_GAP;
+        };
+        count(abstractTok, 0);
+        count(titleTok, 1);
+        count(authorTok, 2);
+
+        docLengths.resize(docId + 1, 0);
+        docLengths[docId] = static_cast<uint32_t>(titleTok.size() + abstractTok.size() + authorTok.size());
+
+        for (auto& [wid, e] : freq)
+            inverter.add(wid, { docId, e.first, e.second }, positional ? positions[wid].data() : nullptr);
+        return true;
+    }
+
+    bool writeLexicon() {
+        fs::create_directories(outputDir + "/Lexicon");
+        std::string stem = fs::path(datasetPath).stem().string();
+        std::string outputfile = outputDir + "/Lexicon/Lexicon (" + stem + ").txt";
+        std::ofstream out(outputfile);
+        if (!out.is_open()) {
+            std::cerr << "[Build][ERROR] Cannot open output file: " << outputfile << "\n";
+            return false;
+        }
+        for (size_t id = 1; id < wordsById.size(); ++id)
+            out << wordsById[id] << " " << id << "\n";
+        std::cout << "[Build] Lexicon written to " << outputfile
+                  << ". Total unique words: " << wordsById.size() - 1 << "\n";
+        return true;
+    }
+
+    bool writeDocLengths() {
+        lengthStats = DocLengths::statsOf(docLengths, totalDocs);
+        if (!DocLengths::write(outputDir + "/doclens.bin", docLengths, lengthStats)) {
+            std::cerr << "[Build][ERROR] Cannot write doc lengths in " << outputDir << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool writeBarrels() {
+        BarrelGenerator barrels(outputDir + "/Barrels");
+        if (!barrels.open()) return false;
+        double scale = ranking::impactScale(lengthStats);
+
+        bool ok = true;
+        std::vector<uint8_t> impacts;
+        bool merged = inverter.finish([&](uint32_t wid, const PostingList& list) {
+            double idf = std::log(static_cast<double>(totalDocs) / list.postings.size());
+            double bm25Idf = ranking::idf(static_cast<uint32_t>(list.postings.size()), totalDocs);
+            impacts.clear();
+            for (const Posting& p : list.postings)
+                impacts.push_back(ranking::quantize(
+                    ranking::bm25(p.tf, p.mask, bm25Idf, docLengths[p.docId], lengthStats), scale));
+            ok = ok && barrels.writeTerm(wid, idf, list.postings,
+                                         list.positions.empty() ? nullptr : &list.positions, &impacts);
+        });
+        if (!merged) std::cerr << "[Build][ERROR] Postings could not be merged\n";
+        if (!barrels.close() || !ok || !merged) return false;
+        std::cout << "[Build] Barrels written to " << outputDir << "/Barrels\n";
+        return true;
+    }
+
+public:
+    // memoryBudgetMB bounds the in-memory posting buffer before it spills a run;
+    // withPositions makes every barrel record positional (phrase queries)
+    IndexBuilder(const std::string& dataset, const std::string& outDir = ".", size_t memoryBudgetMB = 1024,
+                 bool withPositions = false)
+        : datasetPath(dataset), outputDir(outDir), positional(withPositions),
+          inverter(memoryBudgetMB * 1024 * 1024, outDir + "/spimi_runs") {}
+
+    bool build() {
+        auto start = std::chrono::steady_clock::now();
+
+        std::ifstream file(datasetPath, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "[Build][ERROR] Cannot open dataset: " << datasetPath << "\n";
+            return false;
+        }
+        fs::create_directories(outputDir);
+        std::ofstream docMap(outputDir + "/AUC.csv");
+        if (!docMap.is_open()) {
+            std::cerr << "[Build][ERROR] Cannot open doc map in " << outputDir << "\n";
+            return false;
+        }
+        docMap << "internal_doc_id,original_doc_id,start_offset,length\n";
+        DocStoreWriter docStore(outputDir + "/docs.bin");
+        if (!docStore.open()) return false;
+
+        std::string line, originalId;
+        uint64_t offset = 0;
+        uint32_t internalId = 0;
+
+        while (std::getline(file, line)) {
+            ++internalId;
+            uint64_t length = line.size();
+            originalId.clear();
+            if (!line.empty() && indexDocument(line, internalId, originalId)) {
+                ++totalDocs;
+                docMap << internalId << "|" << originalId << "|" << offset << "|" << length << "\n";
+                docStore.add(internalId, line);
+            }
+            offset += length + 1;
+
+            if (!inverter.good()) {
+                std::cerr << "[Build][ERROR] Cannot spill postings; stopping at document " << internalId << "\n";
+                return false;
+            }
+            if (internalId % 100000 == 0)
+                std::cout << "\r[Build] Processed " << internalId << " documents..." << std::flush;
+        }
+        std::cout << "\n[Build] Indexed " << totalDocs << " documents.\n";
+        docMap.close();
+
+        if (!docStore.close() || !writeDocLengths() || !writeLexicon() || !writeBarrels()) return false;
+
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "[TIME] Index build took " << ms << " ms\n";
+        return true;
+    }
+};
+
+#endif
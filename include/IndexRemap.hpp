@@ -0,0 +1,171 @@
+#ifndef INDEX_REMAP_HPP
+#define INDEX_REMAP_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <filesystem>
+#include "PostingCodec.hpp"
+#include "MappedFile.hpp"
+#include "BarrelDirectory.hpp"
+#include "barrels.hpp"
+#include "InvertedIndex.hpp"
+
+// Old word ID -> new word ID table for one input lexicon of a merge
+// (LexiconFolder). Stored as a dense array so a lookup is one index:
+//
+//   char magic[8] = "STREMAP\0" | u32 version | u32 count | count x u32 newID
+//
+// newID 0 means the old ID was not in the input lexicon.
+
+class RemapTable {
+private:
+    static constexpr char MAGIC[8] = { 'S', 'T', 'R', 'E', 'M', 'A', 'P', 0 };
+    static constexpr uint32_t VERSION = 1;
+
+public:
+    std::vector<uint32_t> newId; // indexed by old word ID
+
+    uint32_t map(uint32_t oldId) const { return oldId < newId.size() ? newId[oldId] : 0; }
+
+    bool save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        uint32_t count = static_cast<uint32_t>(newId.size());
+        out.write(MAGIC, sizeof(MAGIC));
+        out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(newId.data()), count * sizeof(uint32_t));
+        return static_cast<bool>(out);
+    }
+
+    bool load(const std::string& path) {
+        MappedFile m(path);
+        uint32_t version, count;
+        if (!m.isOpen() || m.size() < 16 || std::memcmp(m.data(), MAGIC, sizeof(MAGIC)) != 0) return false;
+        std::memcpy(&version, m.data() + 8, sizeof(version));
+        std::memcpy(&count, m.data() + 12, sizeof(count));
+        if (version != VERSION || m.size() < 16 + uint64_t(count) * sizeof(uint32_t)) return false;
+        newId.resize(count);
+        std::memcpy(newId.data(), m.data() + 16, count * sizeof(uint32_t));
+        return true;
+    }
+};
+
+// ===================== INDEX REMAPPER =====================
+
+// Rewrites index files built against one input lexicon so they use the merged
+// lexicon's IDs, without re-reading the raw JSON. docOffset is added to every
+// internal doc ID, so shards indexed separately can be given disjoint ranges.
+
+class IndexRemapper {
+public:
+    // Forward index: "docID : wid(count,mask[;positions]) ..." lines
+    static bool remapForwardIndex(const RemapTable& remap, const std::string& inPath,
+                                  const std::string& outPath, uint32_t docOffset = 0) {
+        std::ifstream in(inPath);
+        std::ofstream out(outPath, std::ios::trunc);
+        if (!in.is_open() || !out.is_open()) {
+            std::cerr << "[Remap][ERROR] Cannot open " << inPath << " or " << outPath << "\n";
+            return false;
+        }
+
+        std::string line, text;
+        size_t docs = 0, unmapped = 0;
+        while (std::getline(in, line)) {
+            text.clear();
+            bool ok = InvertedIndex::parseForwardLine(line,
+                [&](unsigned int wid, const Posting& p, const std::vector<uint32_t>& positions) {
+                    if (text.empty()) text = std::to_string(p.docId + docOffset) + " : ";
+                    uint32_t nw = remap.map(wid);
+                    if (nw == 0) { ++unmapped; return; }
+                    PostingCodec::appendText(text, nw, p.tf, p.mask, positions.data(), positions.size());
+                });
+            if (!ok) continue;
+            if (text.empty()) { // a document without postings
+                size_t colon = line.find(':');
+                text = std::to_string(std::stoul(line.substr(0, colon)) + docOffset) + " : ";
+            }
+            out << text << "\n";
+            ++docs;
+        }
+        std::cout << "[Remap] Forward index: " << docs << " docs -> " << outPath << "\n";
+        if (unmapped) std::cerr << "[Remap][WARN] " << unmapped << " postings had no remap entry\n";
+        return static_cast<bool>(out);
+    }
+
+    // Barrels: every term record is decoded from the mapped input barrels and
+    // re-encoded under its new ID, in new ID order, into fresh barrels.
+    static bool remapBarrels(const RemapTable& remap, const std::string& inDir,
+                             const std::string& outDir, uint32_t docOffset = 0,
+                             uint64_t targetBytes = BarrelGenerator::DEFAULT_TARGET_BYTES) {
+        std::error_code ec;
+        if (std::filesystem::equivalent(inDir, outDir, ec)) {
+            std::cerr << "[Remap][ERROR] Output directory must differ from " << inDir << "\n";
+            return false;
+        }
+        BarrelRouting routing;
+        std::vector<DirectoryEntry> entries;
+        if (!routing.load(inDir) || !BarrelDirectory::readAll(inDir + "/directory.bin", entries)) {
+            std::cerr << "[Remap][ERROR] No routing table or directory.bin in " << inDir << "\n";
+            return false;
+        }
+        std::vector<std::unique_ptr<MappedFile>> maps;
+        for (size_t b = 0; b < routing.barrelCount(); ++b)
+            maps.push_back(std::make_unique<MappedFile>(inDir + "/barrel_" + std::to_string(b) + ".bin"));
+
+        // (new ID, old ID) for every term with postings
+        std::vector<std::pair<uint32_t, uint32_t>> order;
+        size_t unmapped = 0;
+        for (uint32_t wid = 0; wid < entries.size(); ++wid) {
+            if (entries[wid].length == 0) continue;
+            uint32_t nw = remap.map(wid);
+            if (nw == 0) { ++unmapped; continue; }
+            order.push_back({ nw, wid });
+        }
+        std::sort(order.begin(), order.end());
+
+        BarrelGenerator out(outDir, targetBytes);
+        if (!out.open()) return false;
+        std::vector<Posting> postings;
+        std::vector<uint32_t> positions;
+        std::vector<uint8_t> impacts;
+        for (auto [nw, wid] : order) {
+            const DirectoryEntry& e = entries[wid];
+            if (e.barrel >= maps.size() || !maps[e.barrel]->isOpen() ||
+                e.offset + e.length > maps[e.barrel]->size()) {
+                std::cerr << "[Remap][ERROR] Record for word " << wid << " is outside its barrel\n";
+                return false;
+            }
+            postings.clear();
+            positions.clear();
+            impacts.clear();
+            PostingHeader h;
+            bool ok = PostingCodec::decodeWithPositions(maps[e.barrel]->data() + e.offset, e.length, h, true,
+                [&](uint32_t doc, uint32_t tf, int mask, uint8_t impact, const uint32_t* pos, size_t n) {
+                    postings.push_back({ doc + docOffset, tf, mask });
+                    impacts.push_back(impact);
+                    positions.insert(positions.end(), pos, pos + n);
+                });
+            if (!ok || h.wordID != wid) {
+                std::cerr << "[Remap][ERROR] Corrupt record for word " << wid << "\n";
+                return false;
+            }
+            if (!out.writeTerm(nw, h.idf, postings, h.positional ? &positions : nullptr,
+                               h.impacts ? &impacts : nullptr))
+                return false;
+        }
+        if (!out.close()) return false;
+
+        std::cout << "[Remap] Barrels: " << order.size() << " terms -> " << outDir << "\n";
+        if (unmapped) std::cerr << "[Remap][WARN] " << unmapped << " terms had no remap entry\n";
+        return true;
+    }
+};
+
+#endif
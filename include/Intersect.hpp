@@ -0,0 +1,101 @@
+#ifndef INTERSECT_HPP
+#define INTERSECT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define INTERSECT_SSE2 1
+#endif
+
+// Intersection kernels for ascending, duplicate-free doc ID arrays.
+//
+// intersect() picks the kernel from the length ratio: when one list is much
+// longer, each element of the short list is located in the long one by
+// galloping (exponential then binary search), costing O(n log(m/n)); for
+// similar lengths a merge compares 4x4 blocks with SSE2. Matches are reported
+// as onMatch(i, j) with a[i] == b[j], in ascending order, so callers can
+// accumulate scores and compact their candidate arrays in place.
+
+namespace intersect {
+
+// Long list this many times longer than the short one -> gallop
+constexpr size_t GALLOP_RATIO = 16;
+
+// First index in [from, n) with a[index] >= target, or n
+inline size_t gallop(const uint32_t* a, size_t n, size_t from, uint32_t target) {
+    if (from >= n || a[from] >= target) return from;
+    size_t step = 1, lo = from, hi = from + 1;
+    while (hi < n && a[hi] < target) {
+        lo = hi;
+        step <<= 1;
+        hi = from + step;
+    }
+    if (hi > n) hi = n;
+    // a[lo] < target, and a[hi] >= target unless hi == n
+    while (lo + 1 < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a[mid] < target) lo = mid;
+        else hi = mid;
+    }
+    return hi;
+}
+
+template <typename F>
+void galloping(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, F&& onMatch) {
+    size_t j = 0;
+    for (size_t i = 0; i < na && j < nb; ++i) {
+        j = gallop(b, nb, j, a[i]);
+        if (j < nb && b[j] == a[i]) onMatch(i, j++);
+    }
+}
+
+template <typename F>
+void scalarMerge(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, size_t i, size_t j, F&& onMatch) {
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) ++i;
+        else if (a[i] > b[j]) ++j;
+        else onMatch(i++, j++);
+    }
+}
+
+template <typename F>
+void blockMerge(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, F&& onMatch) {
+    size_t i = 0, j = 0;
+#ifdef INTERSECT_SSE2
+    while (i + 4 <= na && j + 4 <= nb) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+        // Rotation r puts b[(k + r) & 3] in lane k; a lane of `a` matches in
+        // at most one rotation because both lists are duplicate-free
+        int m0 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, vb)));
+        int m1 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))));
+        int m2 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2)))));
+        int m3 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+        if (m0 | m1 | m2 | m3) {
+            for (size_t k = 0; k < 4; ++k) {
+                int bit = 1 << k;
+                size_t r = (m0 & bit) ? 0 : (m1 & bit) ? 1 : (m2 & bit) ? 2 : (m3 & bit) ? 3 : 4;
+                if (r < 4) onMatch(i + k, j + ((k + r) & 3));
+            }
+        }
+        uint32_t lastA = a[i + 3], lastB = b[j + 3];
+        if (lastA <= lastB) i += 4;
+        if (lastB <= lastA) j += 4;
+    }
+#endif
+    scalarMerge(a, na, b, nb, i, j, onMatch);
+}
+
+// Intersects a (the candidates, usually the shorter list) with b
+template <typename F>
+void intersect(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, F&& onMatch) {
+    if (na == 0 || nb == 0) return;
+    if (nb / na >= GALLOP_RATIO) galloping(a, na, b, nb, onMatch);
+    else blockMerge(a, na, b, nb, onMatch);
+}
+
+} // namespace intersect
+
+#endif
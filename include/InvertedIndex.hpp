@@ -5,28 +5,87 @@
 #include <string>
 #include <unordered_map>
 #include <map>
-#include <tuple>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <vector>
+#include <cstdint>
+#include "PostingCodec.hpp"
+#include "SpimiInverter.hpp"
 
 class InvertedIndex {
     std::string path_lexicon;
     std::string path_forward;
+    size_t memoryBudget; // 0 = invert fully in memory
 
     std::unordered_map<std::string, unsigned int> words;
 
     // In-Memory Inverted Index
     // Key: WordID (Sorted automatically by map)
-    // Value: List of (DocID, Count, Mask)
-    std::map<unsigned int, std::vector<std::tuple<std::string, unsigned int, int>>> i_index;
+    // Value: List of (internal DocID, Count, Mask) plus positions, if indexed
+    std::map<unsigned int, PostingList> i_index;
 
 public:
-    InvertedIndex(std::string p_Lexicon, std::string p_Forward) :
-        path_lexicon(p_Lexicon), path_forward(p_Forward) {}
+    // Parses one forward index line "docID : wid(count,mask[;positions]) ..." and
+    // calls onPosting(wid, posting, positions) for each entry, where positions
+    // is empty for entries without them. Returns false for malformed lines.
+    template <typename F>
+    static bool parseForwardLine(const std::string& line, F&& onPosting) {
+        size_t colonPos = line.find(':');
+        if (colonPos == std::string::npos) return false;
+
+        // Extract internal DocID
+        uint32_t docID;
+        try { docID = static_cast<uint32_t>(std::stoul(line.substr(0, colonPos))); }
+        catch (...) { return false; }
+
+        // Parse the rest of the line
+        std::istringstream iss(line.substr(colonPos + 1));
+        std::string token;
+        std::vector<uint32_t> positions;
+
+        while (iss >> token) {
+            uint32_t wid;
+            Posting p{ docID, 0, 0 };
+            positions.clear();
+            if (PostingCodec::parseText(token, wid, p, positions))
+                onPosting(wid, p, positions);
+        }
+        return true;
+    }
+
+private:
+    // Write one "WordID IDF : DocID(Count,Mask[;positions]) ..." line
+    static void writeTerm(std::ofstream& out, unsigned int wid, unsigned int totalDocsN,
+                          const PostingList& list) {
+        unsigned int df = list.postings.size();
+        // Calculate IDF
+        double idfVal = (df > 0) ? std::log(static_cast<double>(totalDocsN) / df) : 0.0;
+
+        // Write Header: "WordID IDF :"
+        out << wid << " " << idfVal << " : ";
+
+        // Write Postings: "DocID(Count,Mask) ..."
+        std::string text;
+        const uint32_t* pos = list.positions.data();
+        for (const auto& entry : list.postings) {
+            size_t n = list.positions.empty() ? 0 : entry.tf;
+            PostingCodec::appendText(text, entry.docId, entry.tf, entry.mask, pos, n);
+            pos += n;
+        }
+        out << text << "\n";
+    }
+
+    static void addPosting(PostingList& list, const Posting& p, const std::vector<uint32_t>& positions) {
+        list.postings.push_back(p);
+        list.positions.insert(list.positions.end(), positions.begin(), positions.end());
+    }
+
+public:
+    InvertedIndex(std::string p_Lexicon, std::string p_Forward, size_t memoryBudgetBytes = 0) :
+        path_lexicon(p_Lexicon), path_forward(p_Forward), memoryBudget(memoryBudgetBytes) {}
 
     void lexiconCreater() {
         std::ifstream ifs(path_lexicon);
@@ -58,49 +117,15 @@ public:
         while (std::getline(file, line)) {
             if (line.empty()) continue;
 
-            size_t colonPos = line.find(':');
-            if (colonPos == std::string::npos) continue;
-
-            // Extract DocID
-            std::string docID = line.substr(0, colonPos);
-            while (!docID.empty() && docID.back() == ' ') docID.pop_back();
+            // INSERT INTO MEMORY IMMEDIATELY
+            // This flips the index from Doc->Word to Word->Doc
+            if (!parseForwardLine(line, [&](unsigned int wid, const Posting& p, const std::vector<uint32_t>& pos) {
+                    addPosting(i_index[wid], p, pos);
+                }))
+                continue;
 
             totalDocsN++; // Increment document count
 
-            // Parse the rest of the line
-            std::string wordIdsStr = line.substr(colonPos + 1);
-            std::istringstream iss(wordIdsStr);
-            std::string token;
-
-            while (iss >> token) {
-                // Token
-                size_t p1 = token.find('(');
-                size_t p3 = token.find(')');
-
-                if (p1 != std::string::npos && p3 != std::string::npos) {
-                    try {
-                        // Extract Word ID
-                        std::string idPart = token.substr(0, p1);
-                        // Remove commas if present in ID
-                        idPart.erase(std::remove(idPart.begin(), idPart.end(), ','), idPart.end());
-                        unsigned int wid = std::stoul(idPart);
-
-                        // Extract Count and Mask
-                        size_t p2 = token.find(',', p1);
-                        if (p2 != std::string::npos && p2 < p3) {
-                            unsigned int count = std::stoul(token.substr(p1 + 1, p2 - p1 - 1));
-                            int mask = std::stoi(token.substr(p2 + 1, p3 - p2 - 1));
-
-                            // INSERT INTO MEMORY IMMEDIATELY
-                            // This flips the index from Doc->Word to Word->Doc
-                            i_index[wid].push_back(std::make_tuple(docID, count, mask));
-                        }
-                    } catch (...) {
-                        continue;
-                    }
-                }
-            }
-
             // Progress indicator for loading
             if (totalDocsN % 1000 == 0) {
                 std::cout << "\r[Loading] Processed " << totalDocsN << " documents..." << std::flush;
@@ -120,23 +145,7 @@ public:
 
         // Iterate through the map
         for (auto const& pair : i_index) {
-            unsigned int wid = pair.first;
-            auto const& postings = pair.second;
-
-            unsigned int df = postings.size();
-            // Calculate IDF
-            double idfVal = (df > 0) ? std::log(static_cast<double>(totalDocsN) / df) : 0.0;
-
-            // Write Header: "WordID IDF :"
-            out << wid << " " << idfVal << " : ";
-
-            // Write Postings: "DocID(Count,Mask) ..."
-            for (const auto& entry : postings) {
-                out << std::get<0>(entry) << "("
-                    << std::get<1>(entry) << ","
-                    << std::get<2>(entry) << ") ";
-            }
-            out << "\n";
+            writeTerm(out, pair.first, totalDocsN, pair.second);
 
             // Progress Update
             writeCount++;
@@ -149,9 +158,67 @@ public:
         std::cout << "\nDone! 'inverted_index.txt' created successfully." << std::endl;
     }
 
-    void invertedIndex_writer() {
+    // Bounded-memory variant: postings are collected into sorted runs of at
+    // most memoryBudget bytes, spilled to disk and combined by a streaming
+    // k-way merge. Peak memory is the budget plus the largest single posting
+    // list, independent of corpus size. Output is identical to the in-memory path.
+    bool forward_inverted_Index_creator_bounded() {
+        std::cout << "Inverting Forward Index with a " << memoryBudget / (1024 * 1024)
+                  << " MB memory budget..." << std::endl;
+
+        std::ifstream file(path_forward);
+        if (!file.is_open()) {
+            std::cout << "Error: Cannot open Forward Index!" << std::endl;
+            return false;
+        }
+
+        SpimiInverter inverter(memoryBudget, "inverted_runs");
+        std::string line;
+        unsigned int totalDocsN = 0;
+
+        while (std::getline(file, line)) {
+            if (line.empty()) continue;
+            if (!inverter.good()) break;
+            if (!parseForwardLine(line, [&](unsigned int wid, const Posting& p, const std::vector<uint32_t>& pos) {
+                    inverter.add(wid, p, pos.empty() ? nullptr : pos.data());
+                }))
+                continue;
+
+            totalDocsN++;
+            if (totalDocsN % 1000 == 0) {
+                std::cout << "\r[Loading] Processed " << totalDocsN << " documents..." << std::flush;
+            }
+        }
+        file.close();
+        std::cout << "\nRead " << totalDocsN << " documents into " << inverter.runCount() << " run(s)." << std::endl;
+
+        std::ofstream out("inverted_index_tst.txt");
+        if (!out.is_open()) return false;
+
+        size_t writeCount = 0;
+        bool merged = inverter.finish([&](uint32_t wid, const PostingList& list) {
+            writeTerm(out, wid, totalDocsN, list);
+            if (++writeCount % 1000 == 0) {
+                std::cout << "\r[Merging] Saved " << writeCount << " words..." << std::flush;
+            }
+        });
+
+        out.close();
+        if (!merged || !out) {
+            std::cout << "\nError: 'inverted_index_tst.txt' is incomplete!" << std::endl;
+            return false;
+        }
+        std::cout << "\nDone! 'inverted_index_tst.txt' created successfully." << std::endl;
+        return true;
+    }
+
+    // False if the bounded inversion failed; the in-memory path reports its
+    // own errors
+    bool invertedIndex_writer() {
         lexiconCreater();
+        if (memoryBudget > 0) return forward_inverted_Index_creator_bounded();
         forward_inverted_Index_creator();
+        return true;
     }
 };
 
@@ -0,0 +1,286 @@
+#ifndef JSON_FIELDS_HPP
+#define JSON_FIELDS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Tokenizer.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JSON_FIELDS_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// On-demand field extraction from one JSON record (one JSONL line).
+// The indexers read a handful of top-level fields per arXiv record, so
+// instead of building a DOM the record is scanned once: unrequested values
+// are skipped structurally and requested ones are kept as views of their raw
+// text. String contents are decoded (escapes, \uXXXX, surrogate pairs) only
+// when asked for, and appended straight into the caller's buffer.
+//
+// Scanning checks structure (quotes, nesting, separators) but does not fully
+// validate values the caller never reads, in the spirit of simdjson On-Demand.
+
+namespace jsonfields {
+
+// First '"' or '\\' in [p, end), or end. String bodies are the bulk of a
+// record (abstracts), so this is scanned 16 bytes at a time where possible.
+inline const char* findQuoteOrEscape(const char* p, const char* end) {
+#ifdef JSON_FIELDS_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i escape = _mm_set1_epi8('\\');
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned m = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, escape))));
+        if (m) {
+#ifdef _MSC_VER
+            unsigned long i;
+            _BitScanForward(&i, m);
+            return p + i;
+#else
+            return p + __builtin_ctz(m);
+#endif
+        }
+    }
+#endif
+    for (; p < end; ++p)
+        if (*p == '"' || *p == '\\') return p;
+    return end;
+}
+
+inline const char* skipWhitespace(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+    return p;
+}
+
+// p points at an opening quote; returns the position after the closing quote
+inline const char* skipString(const char* p, const char* end) {
+    ++p;
+    while (true) {
+        p = findQuoteOrEscape(p, end);
+        if (p >= end) return nullptr;
+        if (*p == '"') return p + 1;
+        p += 2; // backslash and the escaped character
+    }
+}
+
+// Returns the position after the value starting at p, or nullptr if malformed
+inline const char* skipValue(const char* p, const char* end) {
+    if (p >= end) return nullptr;
+    if (*p == '"') return skipString(p, end);
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        while (p < end) {
+            char c = *p;
+            if (c == '"') {
+                p = skipString(p, end);
+                if (!p) return nullptr;
+                continue;
+            }
+            if (c == '{' || c == '[') ++depth;
+            else if (c == '}' || c == ']') {
+                if (--depth == 0) return p + 1;
+            }
+            ++p;
+        }
+        return nullptr;
+    }
+    // number, true, false, null
+    const char* start = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+           *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+        ++p;
+    return p > start ? p : nullptr;
+}
+
+inline bool isString(std::string_view raw) { return !raw.empty() && raw.front() == '"'; }
+
+inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+inline bool readHex4(const char*& p, const char* end, uint32_t& out) {
+    if (end - p < 4) return false;
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        int h = hexValue(p[i]);
+        if (h < 0) return false;
+        out = out << 4 | static_cast<uint32_t>(h);
+    }
+    p += 4;
+    return true;
+}
+
+// appendString() without the rollback: a bad escape leaves the text decoded
+// before it in out
+inline bool appendStringUnchecked(std::string_view raw, std::string& out) {
+    if (!isString(raw) || raw.size() < 2) return false;
+    const char* p = raw.data() + 1;
+    const char* end = raw.data() + raw.size() - 1; // closing quote
+    while (p < end) {
+        const char* q = findQuoteOrEscape(p, end);
+        out.append(p, q);
+        if (q >= end) break;
+        p = q + 1; // after the backslash
+        if (p >= end) return false;
+        char c = *p++;
+        switch (c) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!readHex4(p, end, cp)) return false;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (end - p < 6 || p[0] != '\\' || p[1] != 'u') return false;
+                    p += 2;
+                    if (!readHex4(p, end, low) || low < 0xDC00 || low > 0xDFFF) return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return false;
+                }
+                tokenizer::appendUtf8(out, cp);
+                break;
+            }
+            default: return false;
+        }
+    }
+    return true;
+}
+
+// Appends the decoded contents of a raw JSON string token (quotes included).
+// Returns false, appending nothing, if raw is not a string or has a bad
+// escape.
+inline bool appendString(std::string_view raw, std::string& out) {
+    size_t mark = out.size();
+    if (appendStringUnchecked(raw, out)) return true;
+    out.resize(mark);
+    return false;
+}
+
+// Calls f(rawElement) for each element of a raw JSON array and returns the
+// element count; 0 if raw is not an array (or is malformed).
+template <typename F>
+size_t forEachElement(std::string_view raw, F&& f) {
+    if (raw.empty() || raw.front() != '[') return 0;
+    const char* p = raw.data() + 1;
+    const char* end = raw.data() + raw.size();
+    size_t n = 0;
+    p = skipWhitespace(p, end);
+    if (p < end && *p == ']') return 0;
+    while (p < end) {
+        const char* e = skipValue(p, end);
+        if (!e) return n;
+        f(std::string_view(p, static_cast<size_t>(e - p)));
+        ++n;
+        p = skipWhitespace(e, end);
+        if (p >= end || *p != ',') break;
+        p = skipWhitespace(p + 1, end);
+    }
+    return n;
+}
+
+// Stores up to `max` raw elements of an array in out; returns the full count
+inline size_t elements(std::string_view raw, std::string_view* out, size_t max) {
+    size_t i = 0;
+    return forEachElement(raw, [&](std::string_view e) {
+        if (i < max) out[i] = e;
+        ++i;
+    });
+}
+
+// Appends the names of a raw authors_parsed array, whose entries are
+// [last, first, suffix], as "first last suffix " per author. Every indexer
+// builds the author field with this, so a record gets the same author
+// tokens and positions whichever path indexes it.
+inline void appendAuthors(std::string_view raw, std::string& out) {
+    forEachElement(raw, [&](std::string_view author) {
+        std::string_view part[3];
+        size_t n = elements(author, part, 3);
+        if (n < 2) return;
+        for (size_t i : { 1, 0, 2 }) {
+            if (i < n && appendString(part[i], out)) out += " ";
+        }
+    });
+}
+
+} // namespace jsonfields
+
+// ===================== RECORD SCANNER =====================
+
+// Extracts a fixed set of top-level fields from JSON object records:
+//
+//   JsonRecord rec{ "id", "title" };
+//   if (rec.scan(line)) jsonfields::appendString(rec.raw(1), title);
+//
+// Field indices follow the constructor's order. Views point into the scanned
+// text and are valid until it changes or the next scan().
+
+class JsonRecord {
+private:
+    std::vector<std::string_view> fields;
+    std::vector<std::string_view> values;
+
+public:
+    JsonRecord(std::initializer_list<std::string_view> names) : fields(names), values(names.size()) {}
+
+    bool scan(std::string_view text) {
+        using namespace jsonfields;
+        for (auto& v : values) v = {};
+        const char* end = text.data() + text.size();
+        const char* p = skipWhitespace(text.data(), end);
+        if (p >= end || *p != '{') return false;
+        p = skipWhitespace(p + 1, end);
+        if (p < end && *p == '}') return skipWhitespace(p + 1, end) == end;
+
+        while (true) {
+            if (p >= end || *p != '"') return false;
+            const char* keyEnd = skipString(p, end);
+            if (!keyEnd) return false;
+            std::string_view key(p + 1, static_cast<size_t>(keyEnd - p - 2));
+
+            p = skipWhitespace(keyEnd, end);
+            if (p >= end || *p != ':') return false;
+            p = skipWhitespace(p + 1, end);
+            const char* valueEnd = skipValue(p, end);
+            if (!valueEnd) return false;
+
+            for (size_t i = 0; i < fields.size(); ++i)
+                if (fields[i] == key) values[i] = std::string_view(p, static_cast<size_t>(valueEnd - p));
+
+            p = skipWhitespace(valueEnd, end);
+            if (p < end && *p == ',') {
+                p = skipWhitespace(p + 1, end);
+                continue;
+            }
+            if (p < end && *p == '}') return skipWhitespace(p + 1, end) == end;
+            return false;
+        }
+    }
+
+    bool has(size_t i) const { return values[i].data() != nullptr; }
+
+    // Raw value text of field i ("" if absent)
+    std::string_view raw(size_t i) const { return values[i]; }
+
+    // Appends the decoded string value of field i; false if absent or not a string
+    bool appendString(size_t i, std::string& out) const { return jsonfields::appendString(values[i], out); }
+};
+
+#endif
@@ -9,133 +9,133 @@
 #include <unordered_map>
 #include <sstream>
 #include <algorithm>
-#include <locale>
 #include <filesystem>
-#include <json.hpp>
-
-using json = nlohmann::json;
+#include <thread>
+#include <vector>
+#include "JsonFields.hpp"
+#include "Tokenizer.hpp"
 
 class Lexicon {
 private:
     std::string path;                 // Path to input file
     unsigned int wordID;              // Counter for unique words
     bool isJson;                      // Flag: true for JSON, false for plain text (.wet)
-
-    std::unordered_set<std::string> stopWords = {
-        "the", "and", "is", "in", "at", "of", "on", "for", "to", "a", "an", "that", "it"
-    }; // Common words to ignore
+    unsigned int threads;             // Tokenizer threads (0 = one per core)
 
     std::unordered_map<std::string, unsigned int> words; // Stores word -> ID mapping
-    std::locale current_locale;                           // Locale for proper Unicode handling
-
-    // Clean a word: keep only letters/numbers, lowercase it
-    std::string cleanWord(const std::string& w) {
-        std::string result;
-        for (char c : w) {
-            if (std::isalpha(c, current_locale))
-                result += std::tolower(c, current_locale);
+
+    // Words of one input chunk, in first-occurrence order
+    struct ChunkWords {
+        std::unordered_set<std::string, tokenizer::StringHash, std::equal_to<>> seen;
+        std::vector<std::string> order;
+    };
+
+    // Top-level fields read from each JSON record
+    enum Field { TITLE, ABSTRACT, SUBMITTER, AUTHORS_PARSED };
+    static JsonRecord recordScanner() { return JsonRecord{ "title", "abstract", "submitter", "authors_parsed" }; }
+
+    // Extract the indexable text of one input line into `content`
+    bool extractContent(const std::string& line, JsonRecord& paper, std::string& content) {
+        if (isJson) {
+            // Process JSON lines: title, abstract, submitter and author names
+            if (!paper.scan(line)) return false;
+
+            if (paper.has(TITLE)) { paper.appendString(TITLE, content); content += " "; }
+            if (paper.has(ABSTRACT)) { paper.appendString(ABSTRACT, content); content += " "; }
+            if (paper.has(SUBMITTER)) { paper.appendString(SUBMITTER, content); content += " "; }
+
+            jsonfields::appendAuthors(paper.raw(AUTHORS_PARSED), content);
+        } else {
+            // Plain text (.wet) files: take the entire line
+            content = line;
         }
-        return result;
+
+        return true;
     }
 
-public:
-    // Constructor: second parameter indicates JSON vs plain text
-    Lexicon(const std::string& filename, bool jsonFile = true)
-        : path(filename), wordID(0), isJson(jsonFile)
-    {
-        try {
-            current_locale = std::locale(""); // Use system UTF-8 locale
-        } catch (...) {
-            std::cout << "Warning: Unable to use UTF-8 locale. Using classic locale.\n";
-            current_locale = std::locale::classic();
+    // Tokenize every line in the byte range [begin, end) into a thread-local word list
+    void tokenizeChunk(std::streamoff begin, std::streamoff end, ChunkWords& out) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return;
+        file.seekg(begin);
+
+        JsonRecord paper = recordScanner();
+        Tokenizer tokens;
+        std::string line, content;
+        std::streamoff pos = begin;
+        while (pos < end && std::getline(file, line)) {
+            pos += static_cast<std::streamoff>(line.size()) + 1;
+            if (line.empty()) continue;
+
+            content.clear();
+            if (!extractContent(line, paper, content)) continue;
+
+            // Normalized words, stop words already dropped
+            for (std::string_view w : tokens.tokenize(content)) {
+                if (out.seen.find(w) == out.seen.end()) {
+                    out.seen.emplace(w);
+                    out.order.emplace_back(w);
+                }
+            }
+        }
+    }
+
+    // Split the file into `n` byte ranges, each starting right after a newline
+    std::vector<std::streamoff> chunkBoundaries(unsigned int n) {
+        std::streamoff size = static_cast<std::streamoff>(std::filesystem::file_size(path));
+        std::vector<std::streamoff> bounds{ 0 };
+        std::ifstream file(path, std::ios::binary);
+        std::string skip;
+        for (unsigned int i = 1; i < n; ++i) {
+            std::streamoff target = std::max(bounds.back(), size * i / n);
+            if (target == 0) continue;
+            file.clear();
+            file.seekg(target - 1);
+            std::getline(file, skip); // runs to the end of the line containing target-1
+            std::streamoff b = file ? static_cast<std::streamoff>(file.tellg()) : size;
+            if (b > bounds.back()) bounds.push_back(b);
         }
+        bounds.push_back(size);
+        return bounds;
     }
 
-    // Read file and build the lexicon map
+public:
+    // Constructor: second parameter indicates JSON vs plain text,
+    // third the number of tokenizer threads (0 = hardware concurrency)
+    Lexicon(const std::string& filename, bool jsonFile = true, unsigned int nThreads = 0)
+        : path(filename), wordID(0), isJson(jsonFile), threads(nThreads) {}
+
+    // Read file and build the lexicon map.
+    // The file is split into line-aligned chunks tokenized in parallel; chunk
+    // word lists are merged in file order, so IDs follow first occurrence and
+    // match a single-threaded build exactly.
     void readfile_createmap() {
-        std::ifstream file(path);
-        if (!file.is_open()) {
+        std::ifstream probe(path);
+        if (!probe.is_open()) {
             std::cout << "CRITICAL ERROR: Cannot open file: " << path << "\n";
             return;
         }
+        probe.close();
 
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.empty()) continue;
+        unsigned int n = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::streamoff> bounds = chunkBoundaries(n);
+        std::vector<ChunkWords> chunks(bounds.size() - 1);
 
-            std::string content;
-
-            if (isJson) {
-                // Process JSON lines: extract "title" and "abstract"
-                try {
-                    json paper = json::parse(line);
-                    
-                    auto safe_get_string = [](const json& j) -> std::string {
-                        if (!j.is_null()) {
-                            // Check if it is a string (optional, but robust)
-                            if (j.is_string()) {
-                                return j.get<std::string>();
-                            }
-                        }
-                        return ""; // Return empty string if null or missing/non-string
-                    };
-                    
-                    if (paper.contains("title")) content += safe_get_string(paper["title"]) + " ";
-                    if (paper.contains("abstract")) content += safe_get_string(paper["abstract"]) + " ";
-
-                    if (paper.contains("submitter")) {
-                        content += safe_get_string(paper["submitter"]) + " ";
-                    }
-                    if (paper.contains("authors_parsed") && paper["authors_parsed"].is_array()) {
-                        const json& authorsArray = paper["authors_parsed"];
-
-                        for (const auto& authorEntry : authorsArray) {
-                            if (authorEntry.is_array() && authorEntry.size() >= 2) {
-
-                                // Use safe_get_string for individual author name parts as well
-                                std::string lastName = safe_get_string(authorEntry.at(0));
-                                std::string firstName = safe_get_string(authorEntry.at(1));
-
-                                content += firstName + " " + lastName + " ";
-
-                                // Include middle initial/suffix if available (Index 2)
-                                if (authorEntry.size() >= 3 && !authorEntry.at(2).empty()) {
-                                    content += safe_get_string(authorEntry.at(2)) + " ";
-                                }
-                            }
-                        }
-                    }
-                } catch (json::parse_error&) { continue; }
-                  catch (json::out_of_range&) { continue; }
-            } else {
-                // Plain text (.wet) files: take the entire line
-                content = line;
-            }
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i + 1 < bounds.size(); ++i)
+            workers.emplace_back(&Lexicon::tokenizeChunk, this, bounds[i], bounds[i + 1], std::ref(chunks[i]));
+        for (auto& t : workers) t.join();
 
-            // Replace all punctuation/non-alphanumeric chars with space
-            std::replace_if(
-                content.begin(), content.end(),
-                [](char c) { return !std::isalnum(c, std::locale()); },
-                ' '
-            );
-
-            // Split line into words
-            std::istringstream iss(content);
-            std::string word;
-            while (iss >> word) {
-                std::string cleaned = cleanWord(word);
-
-                // Add unique, non-stopword words to map
-                if (!cleaned.empty() &&
-                    stopWords.find(cleaned) == stopWords.end() &&
-                    words.find(cleaned) == words.end()) {
-                    words.emplace(cleaned, ++wordID);
-                }
+        for (auto& chunk : chunks) {
+            for (auto& w : chunk.order) {
+                if (words.find(w) == words.end())
+                    words.emplace(std::move(w), ++wordID);
             }
+            chunk = ChunkWords{}; // release memory as we go
         }
 
-        std::cout << "Processed " << words.size() << " unique words.\n";
-        file.close();
+        std::cout << "Processed " << words.size() << " unique words using "
+                  << chunks.size() << " thread(s).\n";
     }
 
     // Getter for read-only access to the word map
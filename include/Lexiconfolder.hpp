@@ -6,72 +6,180 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include "IndexRemap.hpp"
 
 namespace fs = std::filesystem;
 
+// Merges per-shard lexicons into one and records, for every input, how its
+// old word IDs map to the combined ones (see RemapTable), so forward indexes
+// and barrels built per shard can be rewritten instead of re-indexed.
+//
+// Inputs are taken in file name order and each input in old ID order; a word
+// gets its combined ID by first occurrence in that order, so the result does
+// not depend on the thread count. Files are parsed in parallel, words are
+// deduplicated in parallel hash shards, and only the final ID assignment (a
+// k-way merge of the shards' first-occurrence lists) is sequential.
+//
+// Output: <outputDir>/CombinedLexicon.txt and <outputDir>/Remap/<input stem>.remap
+
 class LexiconFolder {
 private:
+    struct Entry {
+        uint32_t oldId;
+        std::string word;
+    };
+
+    struct Input {
+        std::string path;
+        std::vector<Entry> entries;              // sorted by old ID
+        std::vector<std::vector<uint32_t>> byShard; // entry indices per hash shard
+        uint32_t maxOldId = 0;
+    };
+
+    // Words first seen in one hash shard, in first-occurrence order
+    struct Shard {
+        std::unordered_map<std::string_view, uint32_t> index; // word -> position in `first`
+        std::vector<std::pair<uint64_t, std::string_view>> first; // (input << 32 | entry, word)
+        std::vector<uint32_t> combinedId;                         // parallel to `first`
+    };
+
     std::string folderPath;
-    std::unordered_map<std::string, unsigned int> words;
-    unsigned int wordID = 0;
+    std::string outputDir;
+    unsigned int threads;
+    std::vector<std::string> wordsById{ "" }; // combined ID -> word (IDs start at 1)
+
+    // Runs job(i) for i in [0, count) on up to `threads` workers
+    template <typename F>
+    void parallelFor(size_t count, F&& job) {
+        std::atomic<size_t> next{ 0 };
+        size_t n = std::min<size_t>(threads, std::max<size_t>(count, 1));
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < n; ++t)
+            workers.emplace_back([&] {
+                for (size_t i; (i = next.fetch_add(1)) < count; ) job(i);
+            });
+        for (auto& w : workers) w.join();
+    }
+
+    void readInput(Input& in, size_t shardCount) {
+        std::ifstream file(in.path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file: " << in.path << "\n";
+            return;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream iss(line);
+            Entry e;
+            if (!(iss >> e.word >> e.oldId)) continue; // skip malformed lines
+            in.maxOldId = std::max(in.maxOldId, e.oldId);
+            in.entries.push_back(std::move(e));
+        }
+        std::sort(in.entries.begin(), in.entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.oldId < b.oldId; });
+
+        in.byShard.assign(shardCount, {});
+        std::hash<std::string_view> hash;
+        for (uint32_t i = 0; i < in.entries.size(); ++i)
+            in.byShard[hash(in.entries[i].word) % shardCount].push_back(i);
+    }
 
 public:
     // Constructor: provide folder path containing lexicon .txt files
-    LexiconFolder(const std::string& path) : folderPath(path) {}
+    LexiconFolder(const std::string& path, const std::string& outDir = ".", unsigned int nThreads = 0)
+        : folderPath(path), outputDir(outDir),
+          threads(nThreads ? nThreads : std::max(1u, std::thread::hardware_concurrency())) {}
 
     // Read all .txt files in folder and merge into a single lexicon
-    void mergeLexicons() {
-        std::vector<std::string> files;
-
+    bool mergeLexicons() {
         // Step 1: Collect all .txt files in the folder
+        std::vector<Input> inputs;
         for (const auto& entry : fs::directory_iterator(folderPath)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".txt") {
-                files.push_back(entry.path().string());
-            }
+            if (entry.is_regular_file() && entry.path().extension() == ".txt")
+                inputs.push_back({ entry.path().string(), {}, {}, 0 });
+        }
+        std::sort(inputs.begin(), inputs.end(), [](const Input& a, const Input& b) { return a.path < b.path; });
+        if (inputs.empty()) {
+            std::cerr << "No lexicon files in " << folderPath << "\n";
+            return false;
         }
 
-        // Step 2: Read each file and add words to the map
-        for (const auto& file : files) {
-            std::ifstream in(file);
-            if (!in.is_open()) {
-                std::cerr << "Failed to open file: " << file << "\n";
-                continue;
-            }
-
-            std::string line;
-            while (std::getline(in, line)) {
-                std::istringstream iss(line);
-                std::string word;
-                unsigned int id;
-
-                if (!(iss >> word >> id)) continue; // skip malformed lines
+        // Step 2: Parse every input in parallel
+        const size_t shardCount = threads;
+        parallelFor(inputs.size(), [&](size_t i) { readInput(inputs[i], shardCount); });
 
-                // Only insert if word is not already in map
-                if (words.find(word) == words.end()) {
-                    words[word] = ++wordID; // assign new unique ID
+        // Step 3: Deduplicate per shard; inputs and entries are visited in
+        // order, so each shard's `first` list is sorted by occurrence key
+        std::vector<Shard> shards(shardCount);
+        parallelFor(shardCount, [&](size_t s) {
+            Shard& shard = shards[s];
+            for (size_t f = 0; f < inputs.size(); ++f) {
+                for (uint32_t i : inputs[f].byShard[s]) {
+                    std::string_view w = inputs[f].entries[i].word;
+                    if (shard.index.try_emplace(w, static_cast<uint32_t>(shard.first.size())).second)
+                        shard.first.push_back({ uint64_t(f) << 32 | i, w });
                 }
             }
+            shard.combinedId.resize(shard.first.size());
+        });
 
-            in.close();
+        // Step 4: Assign combined IDs in global first-occurrence order
+        using Head = std::pair<uint64_t, size_t>; // (key, shard)
+        std::priority_queue<Head, std::vector<Head>, std::greater<>> heap;
+        std::vector<size_t> pos(shardCount, 0);
+        for (size_t s = 0; s < shardCount; ++s)
+            if (!shards[s].first.empty()) heap.push({ shards[s].first[0].first, s });
+        while (!heap.empty()) {
+            size_t s = heap.top().second;
+            heap.pop();
+            size_t p = pos[s]++;
+            shards[s].combinedId[p] = static_cast<uint32_t>(wordsById.size());
+            wordsById.emplace_back(shards[s].first[p].second);
+            if (pos[s] < shards[s].first.size()) heap.push({ shards[s].first[pos[s]].first, s });
         }
 
-        // Step 3: Write combined lexicon to a single output file
-        std::string outputFile = "CombinedLexicon.txt";
+        // Step 5: Build and write one remap table per input, in parallel
+        fs::create_directories(outputDir + "/Remap");
+        std::atomic<bool> ok{ true };
+        std::hash<std::string_view> hash;
+        parallelFor(inputs.size(), [&](size_t f) {
+            const Input& in = inputs[f];
+            RemapTable remap;
+            remap.newId.assign(in.entries.empty() ? 0 : in.maxOldId + 1, 0);
+            for (const auto& e : in.entries) {
+                const Shard& shard = shards[hash(e.word) % shardCount];
+                remap.newId[e.oldId] = shard.combinedId[shard.index.at(e.word)];
+            }
+            std::string out = outputDir + "/Remap/" + fs::path(in.path).stem().string() + ".remap";
+            if (!remap.save(out)) {
+                std::cerr << "Failed to write remap table: " << out << "\n";
+                ok = false;
+            }
+        });
+
+        // Step 6: Write combined lexicon to a single output file
+        std::string outputFile = outputDir + "/CombinedLexicon.txt";
         std::ofstream out(outputFile);
         if (!out.is_open()) {
             std::cerr << "Failed to open output file: " << outputFile << "\n";
-            return;
-        }
-
-        for (const auto& p : words) {
-            out << p.first << " " << p.second << "\n";
+            return false;
         }
-
+        for (size_t id = 1; id < wordsById.size(); ++id)
+            out << wordsById[id] << " " << id << "\n";
         out.close();
+
         std::cout << "Combined lexicon written to " << outputFile
-                  << " with " << words.size() << " unique words.\n";
+                  << " with " << wordsById.size() - 1 << " unique words from "
+                  << inputs.size() << " lexicons (" << threads << " threads).\n";
+        return ok;
     }
 };
 
@@ -0,0 +1,132 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file (RAII, movable).
+// An empty file maps successfully with size() == 0 and data() == nullptr.
+
+class MappedFile {
+private:
+    const uint8_t* ptr = nullptr;
+    size_t len = 0;
+    bool opened = false;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    enum class Advice { Normal, Random, Sequential, WillNeed };
+
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& o) noexcept { *this = std::move(o); }
+    MappedFile& operator=(MappedFile&& o) noexcept {
+        if (this != &o) {
+            close();
+            std::swap(ptr, o.ptr);
+            std::swap(len, o.len);
+            std::swap(opened, o.opened);
+#ifdef _WIN32
+            std::swap(file, o.file);
+            std::swap(mapping, o.mapping);
+#endif
+        }
+        return *this;
+    }
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) { close(); return false; }
+        len = static_cast<size_t>(size.QuadPart);
+        if (len > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) { close(); return false; }
+            ptr = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (!ptr) { close(); return false; }
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+        len = static_cast<size_t>(st.st_size);
+        if (len > 0) {
+            void* p = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) { ::close(fd); len = 0; return false; }
+            ptr = static_cast<const uint8_t*>(p);
+        }
+        ::close(fd); // the mapping keeps the file alive
+#endif
+        opened = true;
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (ptr) UnmapViewOfFile(ptr);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (ptr) munmap(const_cast<uint8_t*>(ptr), len);
+#endif
+        ptr = nullptr;
+        len = 0;
+        opened = false;
+    }
+
+    // Access-pattern hint for [offset, offset + length); a no-op where unsupported
+    void advise(Advice a, size_t offset = 0, size_t length = SIZE_MAX) const {
+#ifndef _WIN32
+        if (!ptr || offset >= len) return;
+        // madvise needs a page-aligned start
+        static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t start = offset - offset % page;
+        size_t end = (length > len - offset) ? len : offset + length;
+        int flag = a == Advice::Random ? MADV_RANDOM
+                 : a == Advice::Sequential ? MADV_SEQUENTIAL
+                 : a == Advice::WillNeed ? MADV_WILLNEED
+                 : MADV_NORMAL;
+        madvise(const_cast<uint8_t*>(ptr) + start, end - start, flag);
+#else
+        (void)a; (void)offset; (void)length;
+#endif
+    }
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool isOpen() const { return opened; }
+};
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef POSTING_CACHE_HPP
+#define POSTING_CACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Memory-budgeted cache of barrel records (the compressed postings of one
+// term), so the hot terms are served from the heap instead of the barrel
+// mappings and never wait on the disk once warm.
+//
+// Replacement is W-TinyLFU. A new record enters a small LRU window (1% of
+// the budget); what falls out of the window competes for the main area, an
+// SLRU of probation and protected (80%) segments, against the main area's
+// eviction victims, and is admitted only if its estimated access frequency
+// is higher than theirs. Frequencies come from a count-min sketch of 4-bit
+// counters that is halved periodically, so a one-off scan of rare terms
+// cannot flush the frequent ones. Everything is weighted by record size.
+//
+// Terms hash to shards, each with its own mutex, sketch and budget share.
+// Records are handed out as shared pointers and stay valid after eviction.
+// An entry remembers where its record was read from, so a lookup with a
+// different location (a record that has moved) misses.
+
+class PostingCache {
+public:
+    using Record = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t admissions = 0; // window records that won a place in the main area
+        uint64_t rejections = 0; // ... and that lost to the main area's victims
+        uint64_t evictions = 0;
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+        uint64_t budget = 0;
+    };
+
+private:
+    static constexpr size_t ENTRY_OVERHEAD = 96; // list and hash nodes
+    static constexpr size_t SKETCH_WIDTH = 4096; // counters per row and shard, power of two
+    static constexpr int SKETCH_ROWS = 4;
+    static constexpr uint8_t COUNTER_MAX = 15;
+
+    // Count-min sketch; after 10 * width increments every counter is halved
+    class FrequencySketch {
+    private:
+        std::vector<uint8_t> table = std::vector<uint8_t>(SKETCH_ROWS * SKETCH_WIDTH);
+        size_t additions = 0;
+
+        static uint64_t mix(uint64_t x) {
+            x += 0x9E3779B97F4A7C15ull;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        }
+        static size_t slot(uint64_t h, int row) {
+            return row * SKETCH_WIDTH + ((h >> (row * 16)) & (SKETCH_WIDTH - 1));
+        }
+
+    public:
+        void increment(uint32_t key) {
+            uint64_t h = mix(key);
+            bool added = false;
+            for (int r = 0; r < SKETCH_ROWS; ++r) {
+                uint8_t& c = table[slot(h, r)];
+                if (c < COUNTER_MAX) { ++c; added = true; }
+            }
+            if (added && ++additions >= 10 * SKETCH_WIDTH) {
+                for (uint8_t& c : table) c >>= 1;
+                additions /= 2;
+            }
+        }
+
+        uint8_t estimate(uint32_t key) const {
+            uint64_t h = mix(key);
+            uint8_t f = COUNTER_MAX;
+            for (int r = 0; r < SKETCH_ROWS; ++r) f = std::min(f, table[slot(h, r)]);
+            return f;
+        }
+    };
+
+    enum class Segment { Window, Probation, Protected };
+
+    struct Node {
+        uint32_t wid;
+        uint32_t barrel;
+        uint64_t offset;
+        Record record;
+        size_t bytes;
+        Segment segment;
+    };
+    using NodeList = std::list<Node>;
+
+    struct Shard {
+        std::mutex mutex;
+        FrequencySketch sketch;
+        NodeList window, probation, protectedList; // most recently used first
+        size_t windowBytes = 0, probationBytes = 0, protectedBytes = 0;
+        std::unordered_map<uint32_t, NodeList::iterator> index;
+
+        NodeList& list(Segment s) {
+            return s == Segment::Window ? window : s == Segment::Probation ? probation : protectedList;
+        }
+        size_t& bytes(Segment s) {
+            return s == Segment::Window ? windowBytes : s == Segment::Probation ? probationBytes : protectedBytes;
+        }
+        void move(NodeList::iterator it, Segment to) {
+            bytes(it->segment) -= it->bytes;
+            list(to).splice(list(to).begin(), list(it->segment), it);
+            it->segment = to;
+            bytes(to) += it->bytes;
+        }
+        void erase(NodeList::iterator it) {
+            bytes(it->segment) -= it->bytes;
+            index.erase(it->wid);
+            list(it->segment).erase(it);
+        }
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_t shardCount;
+    size_t windowBudget, mainBudget, protectedBudget; // per shard
+
+    std::atomic<uint64_t> hits{ 0 }, misses{ 0 }, admissions{ 0 }, rejections{ 0 }, evictions{ 0 };
+
+    Shard& shardFor(uint32_t wid) { return shards[wid % shardCount]; }
+
+    // Whether a record of wid taking `bytes` wins a place in the main area:
+    // it fits there, or its frequency beats that of every victim that would
+    // have to make room. Victims come from the cold end, probation first,
+    // then protected, and are collected into `victims` if given.
+    bool wins(Shard& s, uint32_t wid, size_t bytes, std::vector<NodeList::iterator>* victims = nullptr) {
+        size_t mainBytes = s.probationBytes + s.protectedBytes;
+        uint8_t freq = s.sketch.estimate(wid);
+        size_t freed = 0;
+        for (Segment seg : { Segment::Probation, Segment::Protected }) {
+            NodeList& l = s.list(seg);
+            for (auto v = l.rbegin(); v != l.rend() && mainBytes - freed + bytes > mainBudget; ++v) {
+                if (s.sketch.estimate(v->wid) >= freq) return false;
+                if (victims) victims->push_back(std::prev(v.base()));
+                freed += v->bytes;
+            }
+        }
+        return true;
+    }
+
+    // Moves the window's LRU record `it` into the main area if it wins a
+    // place there; otherwise it is dropped
+    void admit(Shard& s, NodeList::iterator it) {
+        std::vector<NodeList::iterator> victims;
+        if (!wins(s, it->wid, it->bytes, &victims)) {
+            s.erase(it);
+            rejections.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        for (auto v : victims) s.erase(v);
+        evictions.fetch_add(victims.size(), std::memory_order_relaxed);
+        s.move(it, Segment::Probation);
+        admissions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+public:
+    explicit PostingCache(size_t budgetBytes, size_t shardCount = 8)
+        : shards(std::make_unique<Shard[]>(shardCount ? shardCount : 1)),
+          shardCount(shardCount ? shardCount : 1) {
+        size_t perShard = budgetBytes / this->shardCount;
+        windowBudget = perShard / 100;
+        mainBudget = perShard - windowBudget;
+        protectedBudget = mainBudget / 5 * 4;
+    }
+
+    PostingCache(const PostingCache&) = delete;
+    PostingCache& operator=(const PostingCache&) = delete;
+
+    // The cached record of wid if it was read from (barrel, offset), else
+    // null. Every call counts toward the term's frequency.
+    Record get(uint32_t wid, uint32_t barrel, uint64_t offset) {
+        Shard& s = shardFor(wid);
+        std::lock_guard lock(s.mutex);
+        s.sketch.increment(wid);
+        auto found = s.index.find(wid);
+        if (found == s.index.end() || found->second->barrel != barrel || found->second->offset != offset) {
+            if (found != s.index.end()) s.erase(found->second);
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto it = found->second;
+        if (it->segment == Segment::Window) {
+            s.move(it, Segment::Window);
+        } else {
+            // A second hit promotes to protected; its overflow drops back to probation
+            s.move(it, Segment::Protected);
+            while (s.protectedBytes > protectedBudget && s.protectedList.size() > 1)
+                s.move(std::prev(s.protectedList.end()), Segment::Probation);
+        }
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return it->record;
+    }
+
+    // Offers the record read from (barrel, offset) after a miss. Returns a
+    // copy to read from, or null if the record is not kept: it is larger
+    // than a shard's main area, or larger than the window and loses
+    // admission. A smaller record always enters the window, so only it is
+    // copied before its admission is decided; the copy may lose later.
+    Record put(uint32_t wid, uint32_t barrel, uint64_t offset, const uint8_t* data, size_t length) {
+        size_t bytes = length + ENTRY_OVERHEAD;
+        if (bytes > mainBudget) return nullptr;
+
+        Shard& s = shardFor(wid);
+        {
+            // The copy is made outside the lock, so the check is repeated below
+            std::lock_guard lock(s.mutex);
+            auto found = s.index.find(wid);
+            if (found != s.index.end() && found->second->barrel == barrel && found->second->offset == offset)
+                return found->second->record;
+            if (bytes > windowBudget && !wins(s, wid, bytes)) {
+                rejections.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+        auto record = std::make_shared<const std::vector<uint8_t>>(data, data + length);
+
+        std::lock_guard lock(s.mutex);
+        auto found = s.index.find(wid);
+        if (found != s.index.end()) {
+            // Another thread got here first
+            if (found->second->barrel == barrel && found->second->offset == offset) return found->second->record;
+            s.erase(found->second);
+        }
+
+        s.window.push_front({ wid, barrel, offset, record, bytes, Segment::Window });
+        s.windowBytes += bytes;
+        s.index.emplace(wid, s.window.begin());
+        while (s.windowBytes > windowBudget && !s.window.empty())
+            admit(s, std::prev(s.window.end()));
+        return record;
+    }
+
+    Stats stats() {
+        Stats st;
+        st.hits = hits.load(std::memory_order_relaxed);
+        st.misses = misses.load(std::memory_order_relaxed);
+        st.admissions = admissions.load(std::memory_order_relaxed);
+        st.rejections = rejections.load(std::memory_order_relaxed);
+        st.evictions = evictions.load(std::memory_order_relaxed);
+        st.budget = (windowBudget + mainBudget) * shardCount;
+        for (size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard lock(shards[i].mutex);
+            st.entries += shards[i].index.size();
+            st.bytes += shards[i].windowBytes + shards[i].probationBytes + shards[i].protectedBytes;
+        }
+        return st;
+    }
+};
+
+#endif
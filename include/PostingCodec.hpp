@@ -0,0 +1,479 @@
+#ifndef POSTING_CODEC_HPP
+#define POSTING_CODEC_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Binary posting format shared by every barrel writer and by SearchEngine.
+//
+// One record per term:
+//   varint wordID | f64 idf | varint df | varint blockCount<<2 | impacts<<1 | positional
+//   blockCount x { varint lastDocDelta, varint payloadBytes [, varint positionBytes],
+//                  f32 maxScore [, u8 maxImpact] }                 <- skip table
+//   blockCount x { payload [, positions] }
+//
+// A payload holds up to BLOCK_SIZE postings as (varint docGap, varint tf<<2|mask
+// [, u8 impact]). Doc IDs are the dense internal IDs from the doc map, sorted
+// ascending; the first gap of each block is relative to the previous block's
+// last doc. maxScore is the highest termScore() in the block, rounded up to a
+// float, so query evaluation can skip blocks that cannot reach the top-k.
+//
+// Records with impacts store each posting's quantized BM25 score (see
+// Ranking.hpp) and the block's highest one, for the same purpose.
+//
+// Positional records follow each payload with the word positions of its
+// postings: tf varint gaps per posting, in posting order, each list starting
+// from 0. Positions count tokens after stop word removal, per document.
+// Fields are numbered abstract, title, authors, each starting FIELD_GAP past
+// the end of the previous one so phrases never match across fields.
+//
+// The text forward and inverted index files write an entry as
+// "id(tf,mask)", or "id(tf,mask;p1,p2,...)" with absolute positions.
+
+struct Posting {
+    uint32_t docId;
+    uint32_t tf;
+    int mask;
+};
+
+struct PostingHeader {
+    uint32_t wordID = 0;
+    double idf = 0.0;
+    uint32_t df = 0;
+    uint32_t blockCount = 0;
+    bool positional = false;
+    bool impacts = false;
+};
+
+// One term's postings with their positions back to back (tf per posting, in
+// posting order); positions is empty when the term is not positional
+struct PostingList {
+    std::vector<Posting> postings;
+    std::vector<uint32_t> positions;
+};
+
+namespace PostingCodec {
+
+constexpr size_t BLOCK_SIZE = 128;
+constexpr uint32_t FIELD_GAP = 64;
+
+// Ranking contribution of one posting: tf-idf plus a bonus for title (mask 1)
+// and author (mask 2) matches
+inline double termScore(uint32_t tf, int mask, double idf) {
+    double s = tf * idf;
+    if (mask == 1) s += 10;
+    else if (mask == 2) s += 5;
+    return s;
+}
+
+// Smallest float not below d, so stored block maxima stay upper bounds
+inline float roundUp(double d) {
+    float f = static_cast<float>(d);
+    return static_cast<double>(f) < d ? std::nextafter(f, std::numeric_limits<float>::infinity()) : f;
+}
+
+// ===================== VARINT =====================
+
+inline void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline void putDouble(std::string& out, double d) {
+    char buf[sizeof(double)];
+    std::memcpy(buf, &d, sizeof(double));
+    out.append(buf, sizeof(double));
+}
+
+inline bool getDouble(const uint8_t*& p, const uint8_t* end, double& d) {
+    if (end - p < static_cast<std::ptrdiff_t>(sizeof(double))) return false;
+    std::memcpy(&d, p, sizeof(double));
+    p += sizeof(double);
+    return true;
+}
+
+inline void putFloat(std::string& out, float f) {
+    char buf[sizeof(float)];
+    std::memcpy(buf, &f, sizeof(float));
+    out.append(buf, sizeof(float));
+}
+
+inline bool getFloat(const uint8_t*& p, const uint8_t* end, float& f) {
+    if (end - p < static_cast<std::ptrdiff_t>(sizeof(float))) return false;
+    std::memcpy(&f, p, sizeof(float));
+    p += sizeof(float);
+    return true;
+}
+
+// ===================== TEXT ENTRIES =====================
+
+inline void appendText(std::string& out, uint32_t id, uint32_t tf, int mask,
+                       const uint32_t* positions = nullptr, size_t count = 0) {
+    out += std::to_string(id);
+    out += '(';
+    out += std::to_string(tf);
+    out += ',';
+    out += std::to_string(mask);
+    for (size_t i = 0; i < count; ++i) {
+        out += i == 0 ? ';' : ',';
+        out += std::to_string(positions[i]);
+    }
+    out += ") ";
+}
+
+// Parses one "id(tf,mask[;p1,...])" entry; commas inside the ID are ignored.
+// Positions are appended to `positions`. Returns false if malformed.
+inline bool parseText(std::string_view token, uint32_t& id, Posting& p, std::vector<uint32_t>& positions) {
+    size_t p1 = token.find('(');
+    size_t p3 = token.find(')', p1);
+    size_t p2 = token.find(',', p1);
+    if (p1 == std::string_view::npos || p3 == std::string_view::npos || p2 == std::string_view::npos || p2 > p3)
+        return false;
+
+    auto number = [](std::string_view s, uint64_t& v, bool allowCommas) {
+        v = 0;
+        bool any = false;
+        for (char c : s) {
+            if (c >= '0' && c <= '9') { v = v * 10 + (c - '0'); any = true; }
+            else if (!(allowCommas && c == ',')) return false;
+        }
+        return any;
+    };
+
+    uint64_t v;
+    if (!number(token.substr(0, p1), v, true)) return false;
+    id = static_cast<uint32_t>(v);
+    if (!number(token.substr(p1 + 1, p2 - p1 - 1), v, false)) return false;
+    p.tf = static_cast<uint32_t>(v);
+
+    std::string_view rest = token.substr(p2 + 1, p3 - p2 - 1);
+    size_t semi = rest.find(';');
+    bool negative = !rest.empty() && rest[0] == '-';
+    if (!number(rest.substr(negative, std::min(semi, rest.size()) - negative), v, false)) return false;
+    p.mask = negative ? -static_cast<int>(v) : static_cast<int>(v);
+    if (semi == std::string_view::npos) return true;
+
+    rest.remove_prefix(semi + 1);
+    while (!rest.empty()) {
+        size_t comma = rest.find(',');
+        if (!number(rest.substr(0, comma), v, false)) return false;
+        positions.push_back(static_cast<uint32_t>(v));
+        if (comma == std::string_view::npos) break;
+        rest.remove_prefix(comma + 1);
+    }
+    return true;
+}
+
+// ===================== RECORDS =====================
+
+// Appends one term record to `out`. `postings` must be sorted by docId.
+// `positions`, if given, holds each posting's tf positions back to back in
+// posting order (ascending within a posting) and makes the record positional.
+// `impacts`, if given, holds one impact per posting.
+inline void encode(std::string& out, uint32_t wordID, double idf, const std::vector<Posting>& postings,
+                   const std::vector<uint32_t>* positions = nullptr,
+                   const std::vector<uint8_t>* impacts = nullptr) {
+    size_t blockCount = (postings.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    bool positional = positions != nullptr;
+
+    putVarint(out, wordID);
+    putDouble(out, idf);
+    putVarint(out, postings.size());
+    putVarint(out, (static_cast<uint64_t>(blockCount) << 2) | (impacts ? 2 : 0) | (positional ? 1 : 0));
+
+    std::string skips, payloads, block, pos;
+    uint32_t prev = 0;
+    size_t nextPos = 0;
+    for (size_t b = 0; b < blockCount; ++b) {
+        uint32_t blockStart = prev;
+        double maxScore = 0.0;
+        uint8_t maxImpact = 0;
+        block.clear();
+        pos.clear();
+        size_t end = std::min(postings.size(), (b + 1) * BLOCK_SIZE);
+        for (size_t i = b * BLOCK_SIZE; i < end; ++i) {
+            const Posting& e = postings[i];
+            putVarint(block, e.docId - prev);
+            putVarint(block, (static_cast<uint64_t>(e.tf) << 2) | (e.mask & 3));
+            prev = e.docId;
+            maxScore = std::max(maxScore, termScore(e.tf, e.mask & 3, idf));
+            if (impacts) {
+                uint8_t impact = i < impacts->size() ? (*impacts)[i] : 0;
+                block.push_back(static_cast<char>(impact));
+                maxImpact = std::max(maxImpact, impact);
+            }
+            if (positional) {
+                uint32_t last = 0;
+                for (uint32_t k = 0; k < e.tf; ++k, ++nextPos) {
+                    uint32_t p = nextPos < positions->size() ? (*positions)[nextPos] : last;
+                    putVarint(pos, p - last);
+                    last = p;
+                }
+            }
+        }
+        putVarint(skips, prev - blockStart);
+        putVarint(skips, block.size());
+        if (positional) putVarint(skips, pos.size());
+        putFloat(skips, roundUp(maxScore));
+        if (impacts) skips.push_back(static_cast<char>(maxImpact));
+        payloads += block;
+        payloads += pos;
+    }
+    out += skips;
+    out += payloads;
+}
+
+// ===================== DECODE =====================
+
+inline bool decodeHeader(const uint8_t*& p, const uint8_t* end, PostingHeader& h) {
+    uint64_t v;
+    if (!getVarint(p, end, v)) return false;
+    h.wordID = static_cast<uint32_t>(v);
+    if (!getDouble(p, end, h.idf)) return false;
+    if (!getVarint(p, end, v)) return false;
+    h.df = static_cast<uint32_t>(v);
+    if (!getVarint(p, end, v)) return false;
+    h.blockCount = static_cast<uint32_t>(v >> 2);
+    h.impacts = (v & 2) != 0;
+    h.positional = (v & 1) != 0;
+    return true;
+}
+
+// Decodes a whole record, calling onPosting(docId, tf, mask, impact, positions,
+// count) in docId order; impact is 0 if the record has none. `positions`
+// points at the posting's decoded positions
+// (count == tf), or is nullptr with count 0 if the record is not positional
+// or wantPositions is false, in which case they are skipped undecoded.
+template <typename F>
+bool decodeWithPositions(const uint8_t* p, size_t len, PostingHeader& h, bool wantPositions, F&& onPosting) {
+    const uint8_t* end = p + len;
+    if (!decodeHeader(p, end, h)) return false;
+
+    // The skip table is only needed for skipping, except for the sizes of
+    // position sections a full decode may pass over.
+    std::vector<uint64_t> positionBytes;
+    uint64_t v;
+    float f;
+    for (uint32_t b = 0; b < h.blockCount; ++b) {
+        if (!getVarint(p, end, v) || !getVarint(p, end, v)) return false;
+        if (h.positional) {
+            if (!getVarint(p, end, v)) return false;
+            positionBytes.push_back(v);
+        }
+        if (!getFloat(p, end, f)) return false;
+        if (h.impacts && p++ == end) return false;
+    }
+
+    std::vector<uint32_t> tfs, pos;
+    uint32_t doc = 0;
+    for (uint32_t b = 0; b < h.blockCount; ++b) {
+        uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(BLOCK_SIZE, h.df - b * BLOCK_SIZE));
+        // Payload first; positions of this block follow it
+        uint32_t docs[BLOCK_SIZE];
+        int masks[BLOCK_SIZE];
+        uint8_t impacts[BLOCK_SIZE] = {};
+        tfs.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint64_t gap, packed;
+            if (!getVarint(p, end, gap) || !getVarint(p, end, packed)) return false;
+            doc += static_cast<uint32_t>(gap);
+            docs[i] = doc;
+            tfs[i] = static_cast<uint32_t>(packed >> 2);
+            masks[i] = static_cast<int>(packed & 3);
+            if (h.impacts) {
+                if (p == end) return false;
+                impacts[i] = *p++;
+            }
+        }
+
+        if (h.positional && wantPositions) {
+            for (uint32_t i = 0; i < count; ++i) {
+                pos.resize(tfs[i]);
+                uint32_t last = 0;
+                for (uint32_t k = 0; k < tfs[i]; ++k) {
+                    if (!getVarint(p, end, v)) return false;
+                    last += static_cast<uint32_t>(v);
+                    pos[k] = last;
+                }
+                onPosting(docs[i], tfs[i], masks[i], impacts[i], pos.data(), static_cast<size_t>(tfs[i]));
+            }
+        } else {
+            for (uint32_t i = 0; i < count; ++i)
+                onPosting(docs[i], tfs[i], masks[i], impacts[i], static_cast<const uint32_t*>(nullptr), size_t(0));
+            if (h.positional) {
+                if (positionBytes[b] > static_cast<uint64_t>(end - p)) return false;
+                p += positionBytes[b];
+            }
+        }
+    }
+    return true;
+}
+
+// Decodes a whole record, calling onPosting(docId, tf, mask) in docId order.
+template <typename F>
+bool decode(const uint8_t* p, size_t len, PostingHeader& h, F&& onPosting) {
+    return decodeWithPositions(p, len, h, false,
+        [&](uint32_t doc, uint32_t tf, int mask, uint8_t, const uint32_t*, size_t) { onPosting(doc, tf, mask); });
+}
+
+} // namespace PostingCodec
+
+// ===================== POSTING CURSOR =====================
+
+// Forward iterator over one record that decodes a block only when a posting
+// in it is needed. open() reads the skip table, so a cursor can move to the
+// block that may hold a doc (shallowSeek) and read that block's maxScore and
+// maxImpact without decoding anything. Only the first `limit` postings are
+// visited.
+
+class PostingCursor {
+public:
+    static constexpr uint32_t END = UINT32_MAX;
+
+private:
+    struct Block {
+        uint32_t lastDoc;
+        uint32_t count;
+        float maxScore;
+        uint8_t maxImpact;
+        const uint8_t* payload;
+    };
+
+    PostingHeader h;
+    const uint8_t* end = nullptr;
+    std::vector<Block> blocks;
+    float listMax = 0.0f;
+
+    size_t block = 0;          // block under the cursor (shallow position)
+    size_t decoded = SIZE_MAX; // block whose postings are in the buffers
+    size_t index = 0;          // posting within the decoded block
+    uint32_t current = END;    // doc under the cursor
+    uint32_t docs[PostingCodec::BLOCK_SIZE];
+    uint32_t tfs[PostingCodec::BLOCK_SIZE];
+    int masks[PostingCodec::BLOCK_SIZE];
+    uint8_t impacts[PostingCodec::BLOCK_SIZE] = {};
+    size_t blocksDecoded = 0;
+
+    bool decodeBlock(size_t b) {
+        const uint8_t* p = blocks[b].payload;
+        uint32_t doc = b == 0 ? 0 : blocks[b - 1].lastDoc;
+        for (uint32_t i = 0; i < blocks[b].count; ++i) {
+            uint64_t gap, packed;
+            if (!PostingCodec::getVarint(p, end, gap) || !PostingCodec::getVarint(p, end, packed)) return false;
+            doc += static_cast<uint32_t>(gap);
+            docs[i] = doc;
+            tfs[i] = static_cast<uint32_t>(packed >> 2);
+            masks[i] = static_cast<int>(packed & 3);
+            if (h.impacts) {
+                if (p == end) return false;
+                impacts[i] = *p++;
+            }
+        }
+        decoded = b;
+        index = 0;
+        ++blocksDecoded;
+        return true;
+    }
+
+public:
+    // Parses the header and skip table; false if the record is malformed
+    bool open(const uint8_t* p, size_t len, size_t limit = SIZE_MAX) {
+        end = p + len;
+        blocks.clear();
+        block = 0;
+        decoded = SIZE_MAX;
+        current = END;
+        listMax = 0.0f;
+        if (!PostingCodec::decodeHeader(p, end, h)) return false;
+
+        size_t total = std::min<size_t>(h.df, limit);
+        std::vector<uint64_t> sizes;
+        uint32_t lastDoc = 0;
+        for (uint32_t b = 0; b < h.blockCount; ++b) {
+            uint64_t delta, payloadBytes, positionBytes = 0;
+            float maxScore;
+            uint8_t maxImpact = 0;
+            if (!PostingCodec::getVarint(p, end, delta) || !PostingCodec::getVarint(p, end, payloadBytes) ||
+                (h.positional && !PostingCodec::getVarint(p, end, positionBytes)) ||
+                !PostingCodec::getFloat(p, end, maxScore) || (h.impacts && p == end))
+                return false;
+            if (h.impacts) maxImpact = *p++;
+            lastDoc += static_cast<uint32_t>(delta);
+            size_t first = b * PostingCodec::BLOCK_SIZE;
+            if (first < total) {
+                uint32_t count = static_cast<uint32_t>(std::min(PostingCodec::BLOCK_SIZE, total - first));
+                blocks.push_back({ lastDoc, count, maxScore, maxImpact, nullptr });
+            }
+            sizes.push_back(payloadBytes + positionBytes);
+        }
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            if (sizes[b] > static_cast<uint64_t>(end - p)) return false;
+            blocks[b].payload = p;
+            p += sizes[b];
+            listMax = std::max(listMax, blocks[b].maxScore);
+        }
+        return true;
+    }
+
+    const PostingHeader& header() const { return h; }
+    float maxScore() const { return listMax; }
+    size_t size() const { return blocks.empty() ? 0 : (blocks.size() - 1) * PostingCodec::BLOCK_SIZE + blocks.back().count; }
+    size_t decodedBlockCount() const { return blocksDecoded; }
+
+    // Current posting after seek()/next(); doc() is END once the list is exhausted
+    uint32_t doc() const { return current; }
+    uint32_t tf() const { return tfs[index]; }
+    int mask() const { return masks[index]; }
+    uint8_t impact() const { return impacts[index]; }
+
+    // Moves to the first block whose last doc is >= target, without decoding.
+    // Afterwards blockMaxScore() and blockLastDoc() describe that block.
+    void shallowSeek(uint32_t target) {
+        while (block < blocks.size() && blocks[block].lastDoc < target) ++block;
+    }
+    float blockMaxScore() const { return block < blocks.size() ? blocks[block].maxScore : 0.0f; }
+    uint8_t blockMaxImpact() const { return block < blocks.size() ? blocks[block].maxImpact : 0; }
+    uint32_t blockLastDoc() const { return block < blocks.size() ? blocks[block].lastDoc : END; }
+
+    // First posting with doc >= target; returns its doc or END
+    uint32_t seek(uint32_t target) {
+        shallowSeek(target);
+        while (block < blocks.size()) {
+            if (decoded != block && !decodeBlock(block)) { block = blocks.size(); break; }
+            while (index < blocks[block].count && docs[index] < target) ++index;
+            if (index < blocks[block].count) return current = docs[index];
+            ++block; // a truncated last block may end before its recorded lastDoc
+        }
+        return current = END;
+    }
+
+    // Next posting after the current one
+    uint32_t next() {
+        if (current == END) return END;
+        if (decoded == block && index + 1 < blocks[block].count) return current = docs[++index];
+        ++block;
+        return seek(0);
+    }
+};
+
+#endif // POSTING_CODEC_HPP
@@ -0,0 +1,78 @@
+#ifndef RANKING_HPP
+#define RANKING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+
+// Ranking functions a query can be scored with.
+//
+//   TfIdf  - tf * idf plus a flat bonus for title and author matches
+//            (PostingCodec::termScore), the original ranking
+//   BM25   - Okapi BM25 over the whole document, normalized by the length
+//            column (DocLengths.hpp), computed per posting at query time
+//   Impact - BM25 quantized to 8 bits at index time and stored in the
+//            postings, so a query only adds small integers
+//
+// Postings carry one tf over all fields plus the mask of the last field the
+// term occurs in, not per-field counts. BM25 therefore follows BM25F as far
+// as the index allows: the occurrence known to be in the title or authors is
+// credited with that field's weight before saturation.
+
+enum class Ranking { TfIdf, BM25, Impact };
+
+// Collection statistics BM25 normalizes with, fixed when the index is built
+struct CollectionStats {
+    uint32_t docs = 0;       // documents indexed
+    double avgLength = 0.0;  // mean tokens per document
+};
+
+namespace ranking {
+
+constexpr double K1 = 1.2;
+constexpr double B = 0.75;
+// Extra occurrences credited for a match in the title (mask 1) or the authors (mask 2)
+constexpr double TITLE_BOOST = 2.0;
+constexpr double AUTHOR_BOOST = 1.0;
+// Impacts run 1..IMPACT_LEVELS, so every stored posting counts
+constexpr int IMPACT_LEVELS = 255;
+
+inline const char* name(Ranking r) {
+    return r == Ranking::BM25 ? "bm25" : r == Ranking::Impact ? "impact" : "tfidf";
+}
+
+inline bool parse(std::string_view s, Ranking& out) {
+    for (Ranking r : { Ranking::TfIdf, Ranking::BM25, Ranking::Impact })
+        if (s == name(r)) { out = r; return true; }
+    return false;
+}
+
+// Never negative; df may exceed docs once documents are added after the build
+inline double idf(uint32_t df, uint32_t docs) {
+    double n = std::max(docs, df);
+    return std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+}
+
+inline double bm25(uint32_t tf, int mask, double idf, double length, const CollectionStats& s) {
+    double f = tf + (mask == 1 ? TITLE_BOOST : mask == 2 ? AUTHOR_BOOST : 0.0);
+    double norm = K1 * (1.0 - B + B * length / s.avgLength);
+    return idf * f * (K1 + 1.0) / (f + norm);
+}
+
+// Score of one impact unit. bm25() stays below idf * (K1 + 1), and idf is
+// highest at df == 1, so every score of the collection fits the range.
+inline double impactScale(const CollectionStats& s) {
+    return idf(1, s.docs) * (K1 + 1.0) / IMPACT_LEVELS;
+}
+
+// Rounds up, so impact * scale bounds the exact score (block maxima stay
+// valid for BM25 too)
+inline uint8_t quantize(double score, double scale) {
+    double q = std::floor(score / scale) + 1.0;
+    return static_cast<uint8_t>(std::clamp(q, 1.0, static_cast<double>(IMPACT_LEVELS)));
+}
+
+} // namespace ranking
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Concurrent cache of serialized /search responses, keyed on the normalized
+// query and page, each stored with its next-page cursor. Keys hash to one of
+// a fixed number of shards, each an LRU list with its own mutex and an equal
+// share of the byte budget, so concurrent lookups rarely contend.
+//
+// Every entry is stamped with the index generation it was computed at. A
+// lookup passes the current generation; an entry from an older one is a miss
+// and is dropped, so bumping the generation invalidates the whole cache
+// without a sweep.
+
+class ResultCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+        uint64_t budget = 0;
+    };
+
+private:
+    // Charged per entry on top of key and body: list node, hash node, bookkeeping
+    static constexpr size_t ENTRY_OVERHEAD = 128;
+
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const std::string> body;
+        std::string next; // cursor of the following page, empty on the last
+        uint64_t generation;
+        size_t bytes;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru; // most recently used first
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index; // views into lru keys
+        size_t bytes = 0;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_t shardCount;
+    size_t shardBudget;
+
+    std::atomic<uint64_t> hits{ 0 };
+    std::atomic<uint64_t> misses{ 0 };
+    std::atomic<uint64_t> evictions{ 0 };
+
+    Shard& shardFor(std::string_view key) {
+        return shards[std::hash<std::string_view>{}(key) % shardCount];
+    }
+
+    static void erase(Shard& s, std::list<Entry>::iterator it) {
+        s.bytes -= it->bytes;
+        s.index.erase(it->key);
+        s.lru.erase(it);
+    }
+
+public:
+    explicit ResultCache(size_t budgetBytes = 64u << 20, size_t shardCount = 16)
+        : shards(std::make_unique<Shard[]>(shardCount ? shardCount : 1)),
+          shardCount(shardCount ? shardCount : 1),
+          shardBudget(budgetBytes / (shardCount ? shardCount : 1)) {}
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // The cached body for key if it was stored at this generation, else null;
+    // `next`, if given, receives the stored cursor on a hit
+    std::shared_ptr<const std::string> get(std::string_view key, uint64_t generation, std::string* next = nullptr) {
+        Shard& s = shardFor(key);
+        std::lock_guard lock(s.mutex);
+        auto found = s.index.find(key);
+        if (found == s.index.end()) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        auto it = found->second;
+        if (it->generation != generation) {
+            erase(s, it);
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        s.lru.splice(s.lru.begin(), s.lru, it);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        if (next) *next = it->next;
+        return it->body;
+    }
+
+    // Stores body under key, evicting least recently used entries of the
+    // shard until it fits. Bodies larger than a shard's budget are not kept.
+    void put(std::string_view key, uint64_t generation, std::string body, std::string next = "") {
+        size_t bytes = key.size() + body.size() + next.size() + ENTRY_OVERHEAD;
+        if (bytes > shardBudget) return;
+
+        auto shared = std::make_shared<const std::string>(std::move(body));
+        Shard& s = shardFor(key);
+        std::lock_guard lock(s.mutex);
+        auto found = s.index.find(key);
+        if (found != s.index.end()) {
+            // A result computed against an older index must not replace a newer one
+            if (found->second->generation > generation) return;
+            erase(s, found->second);
+        }
+        while (!s.lru.empty() && s.bytes + bytes > shardBudget) {
+            erase(s, std::prev(s.lru.end()));
+            evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        s.lru.push_front({ std::string(key), std::move(shared), std::move(next), generation, bytes });
+        s.index.emplace(s.lru.front().key, s.lru.begin());
+        s.bytes += bytes;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard lock(shards[i].mutex);
+            shards[i].index.clear();
+            shards[i].lru.clear();
+            shards[i].bytes = 0;
+        }
+    }
+
+    Stats stats() {
+        Stats st;
+        st.hits = hits.load(std::memory_order_relaxed);
+        st.misses = misses.load(std::memory_order_relaxed);
+        st.evictions = evictions.load(std::memory_order_relaxed);
+        st.budget = shardBudget * shardCount;
+        for (size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard lock(shards[i].mutex);
+            st.entries += shards[i].lru.size();
+            st.bytes += shards[i].bytes;
+        }
+        return st;
+    }
+};
+
+#endif
@@ -5,52 +5,65 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <cmath>
+#include <chrono>
 #include <json.hpp>
+#include "PostingCodec.hpp"
+#include "barrels.hpp"
+#include "MappedFile.hpp"
+#include "BarrelDirectory.hpp"
+#include "DeltaPostings.hpp"
+#include "FlatTables.hpp"
+#include "EngineSnapshot.hpp"
+#include "Tokenizer.hpp"
+#include "Intersect.hpp"
+#include "PostingCache.hpp"
+#include "DocStore.hpp"
+#include "DocLengths.hpp"
+#include "Ranking.hpp"
+#include "SpellIndex.hpp"
+#include "WordVectors.hpp"
+#include "Hnsw.hpp"
+#include "DocVectors.hpp"
 
 using json = nlohmann::json;
 
 // ===================== DATA STRUCTURES =====================
 
-struct Vector {
-    std::vector<float> values;
-    float dot(const Vector& other) const {
-        float sum = 0;
-        for (size_t i = 0; i < values.size(); ++i) sum += values[i] * other.values[i];
-        return sum;
-    }
-    float magnitude() const {
-        return std::sqrt(dot(*this));
-    }
-};
-
-struct DocEntry {
-    std::string docId;
-    int tf;
-    int mask;
-};
+// Postings carry the dense internal doc ID assigned by AUC; the original
+// arXiv ID is only looked up in docTable for the final top-k.
+using DocEntry = Posting;
 
 struct InvertedList {
     double idf = 0.0;
+    uint32_t df = 0;
     std::vector<DocEntry> docs;
-};
+    std::vector<uint32_t> docIds; // docs[i].docId, contiguous for the intersection kernels
+    // Word positions of docs[i] are positions[positionStart[i] .. positionStart[i + 1]);
+    // both stay empty unless positions were requested and the record has them
+    std::vector<uint32_t> positions;
+    std::vector<uint32_t> positionStart;
+    std::vector<uint8_t> impacts; // of docs[i], empty if the record has none
 
-struct DocMetadata {
-    std::string internalId;
-    long long offset = 0;
-    long long length = 0;
+    bool hasPositions() const { return !positionStart.empty(); }
 };
 
 struct SearchResult {
-    std::string docId;
+    uint32_t docId;
     double score;
-    DocMetadata meta;
-    bool operator>(const SearchResult& o) const { return score > o.score; }
+    // Ties go to the lower doc ID so rankings are deterministic.
+    bool operator>(const SearchResult& o) const {
+        return score > o.score || (score == o.score && docId < o.docId);
+    }
 };
 
 struct TermInfo {
@@ -58,14 +71,64 @@ struct TermInfo {
     int wordID;
     size_t docCount;
     InvertedList list;
+    int phrase = -1;            // index into the query's phrases, -1 = free term
+    uint32_t phraseOffset = 0;  // word offset within that phrase
+};
+
+// A quoted query part: "a b c" must match as consecutive words, "a b c"~k
+// within a window of k extra words, in any order.
+struct Phrase {
+    size_t length = 0;
+    bool ordered = true;
+    uint32_t slop = 0;
+};
+
+// Where the next page starts: after the result with this (unscaled) score
+// and doc ID, in the ranking evaluated by `stage` (see SearchEngine::rank).
+// Clients see it only as an opaque string.
+struct PageCursor {
+    double score = 0.0;
+    uint32_t docId = 0;
+    uint8_t stage = 0;
+
+    // r ranks after the cursor's result
+    bool admits(const SearchResult& r) const {
+        return r.score < score || (r.score == score && r.docId > docId);
+    }
+};
+
+// A query resolved to index terms, everything its results depend on. `key`
+// spells it canonically (resolved words in query order, phrases quoted, then
+// the ranking and any page other than the first ten), so queries differing
+// only in case, punctuation, stop words or typos share it.
+struct ParsedQuery {
+    std::vector<TermInfo> terms;
+    std::vector<Phrase> phrases;
+    Ranking ranking = Ranking::TfIdf;
+    std::string key;
+    uint64_t queryHash = 0;   // of the key without the page, binds cursors to the query
+    size_t k = 10;            // results per page
+    size_t offset = 0;        // results skipped before the page
+    bool resume = false;      // the page starts after `after`
+    PageCursor after;
 };
 
 // ===================== SEARCH ENGINE =====================
 
 class SearchEngine {
 private:
-    static constexpr int TOTAL_BARRELS = 100;
     static constexpr size_t MAX_DOCS_PER_TERM = 200000;
+    static constexpr size_t TOP_K = 10;
+    // A page holds at most MAX_PAGE results; offsets past MAX_OFFSET need a
+    // cursor, so no request keeps more than their sum in its heap
+    static constexpr size_t MAX_PAGE = 100;
+    static constexpr size_t MAX_OFFSET = 1000;
+    // Hybrid search fuses this many dense and lexical results, each list's
+    // rank r adding 1 / (RRF_K + r)
+    static constexpr size_t FUSION_DEPTH = 100;
+    static constexpr double RRF_K = 60.0;
+    // Proximity windows stay well inside the gap between fields
+    static constexpr uint32_t MAX_SLOP = PostingCodec::FIELD_GAP / 2;
 
     const std::string BARREL_DIR = "Barrels/";
 
@@ -74,242 +137,1393 @@ private:
         "a","an","in","on","for","with","by","as","at","from","their"
     };
 
-    std::unordered_map<std::string, int> lexicon;
-    std::unordered_map<std::string, DocMetadata> docTable;
-    std::unordered_map<int, long long> barrelIndex[TOTAL_BARRELS];
-    std::unordered_map<std::string, Vector> wordVectors; // For Semantic Search
+    StringTable lexicon;   // word -> word ID
+    SpellIndex spelling;   // one-edit variants of the lexicon's words
+    DocTable docTable;     // indexed by internal doc ID
+    StringTable docIndex;  // original doc ID -> internal doc ID
+    std::shared_ptr<const SnapshotImage> snapshot; // backs both tables when loaded from an image
+    BarrelRouting routing;
+    BarrelDirectory directory; // mapped directory.bin: wid -> (barrel, offset, length, df)
+    std::vector<std::shared_ptr<const MappedFile>> barrelMaps; // guarded by barrelMapsMutex
+    std::shared_mutex barrelMapsMutex;
+    DeltaPostings delta; // postings of documents added since the build
+    std::unique_ptr<PostingCache> postingCache; // hot records, off when null
+    DocStore docStore; // result fields; the raw dataset covers docs it lacks
+    DocLengths docLengths; // BM25 length norms, absent = tf-idf only
+    Ranking defaultRanking = Ranking::TfIdf;
+    WordVectors wordVectors;         // for the semantic fallback, empty = off
+    std::string wordVectorsPath;     // the graph is cached at this + ".hnsw"
+    HnswIndex semanticIndex;         // over the lexicon words that have a vector
+    std::vector<uint32_t> semanticRows; // graph node -> wordVectors row
+    float semanticThreshold = 0.7f;  // minimum cosine similarity of a neighbour
+    DocVectors docVectors;           // document embeddings for /semantic, absent = off
 
     std::string rawDatasetPath;
 
     // ===================== HELPERS =====================
 
-    int parseInt(std::string s) {
-        s.erase(std::remove(s.begin(), s.end(), ','), s.end());
-        try { return std::stoi(s); } catch (...) { return 0; }
-    }
-
     long long parseLong(std::string s) {
         s.erase(std::remove(s.begin(), s.end(), ','), s.end());
         try { return std::stoll(s); } catch (...) { return 0; }
     }
 
-    double score(const DocEntry& e, double idf) {
-        double s = e.tf * idf;
-        if (e.mask == 1) s += 10;
-        else if (e.mask == 2) s += 5;
-        return s;
-    }
+    bool exhaustive = false; // score every candidate instead of block-max pruning
 
-    // --- Spelling Correction Logic (Edit Distance) ---
-    int editDistance(const std::string& s1, const std::string& s2) {
-        int m = s1.length(), n = s2.length();
-        std::vector<std::vector<int>> dp(m + 1, std::vector<int>(n + 1));
-        for (int i = 0; i <= m; i++) dp[i][0] = i;
-        for (int j = 0; j <= n; j++) dp[0][j] = j;
-        for (int i = 1; i <= m; i++) {
-            for (int j = 1; j <= n; j++) {
-                if (s1[i - 1] == s2[j - 1]) dp[i][j] = dp[i - 1][j - 1];
-                else dp[i][j] = 1 + std::min({ dp[i - 1][j], dp[i][j - 1], dp[i - 1][j - 1] });
-            }
+    // How one query scores postings. weight() is a term's idf under the
+    // ranking, taken once per term from its record header; bound() is the
+    // most the cursor's current block can score, for block-max pruning.
+    // Impact ranking quantizes BM25 on the fly for records without impacts.
+    struct Scorer {
+        Ranking mode = Ranking::TfIdf;
+        const DocLengths* lengths = nullptr;
+        double scale = 0.0; // score of one impact unit
+
+        double weight(double idf, uint32_t df) const {
+            return mode == Ranking::TfIdf ? idf : ranking::idf(df, lengths->stats().docs);
+        }
+        double score(uint32_t doc, uint32_t tf, int mask, uint8_t impact, double w) const {
+            if (mode == Ranking::TfIdf) return PostingCodec::termScore(tf, mask, w);
+            if (mode == Ranking::Impact && impact) return impact;
+            double s = ranking::bm25(tf, mask, w, lengths->length(doc), lengths->stats());
+            return mode == Ranking::Impact ? ranking::quantize(s, scale) : s;
+        }
+        double score(const InvertedList& l, size_t i, double w) const {
+            const DocEntry& e = l.docs[i];
+            return score(e.docId, e.tf, e.mask, l.impacts.empty() ? 0 : l.impacts[i], w);
         }
-        return dp[m][n];
+        double score(const PostingCursor& c, double w) const {
+            return score(c.doc(), c.tf(), c.mask(), c.impact(), w);
+        }
+        double bound(const PostingCursor& c) const {
+            if (mode == Ranking::TfIdf) return c.blockMaxScore();
+            if (!c.header().impacts) return std::numeric_limits<double>::infinity();
+            return mode == Ranking::Impact ? c.blockMaxImpact() : c.blockMaxImpact() * scale;
+        }
+    };
+
+    // BM25 and impact ranking fall back to tf-idf without doc lengths
+    Scorer scorerFor(Ranking r) const {
+        Scorer sc;
+        if (!docLengths.isOpen()) return sc;
+        sc.mode = r;
+        sc.lengths = &docLengths;
+        sc.scale = ranking::impactScale(docLengths.stats());
+        return sc;
     }
 
+    // --- Spelling Correction Logic (one edit, via the symmetric-delete index) ---
+    // Of the lexicon words one edit away, the one in the most documents;
+    // ties go to the lower word ID
     std::string findCorrection(const std::string& word) {
-        std::string bestMatch = "";
-        int minDistance = 2; // Threshold for typo tolerance
-        for (auto const& [lexWord, id] : lexicon) {
-            if (std::abs((int)word.length() - (int)lexWord.length()) > minDistance) continue;
-            int dist = editDistance(word, lexWord);
-            if (dist < minDistance) {
-                minDistance = dist;
-                bestMatch = lexWord;
+        size_t best = SIZE_MAX;
+        uint32_t bestDf = 0;
+        spelling.candidates(word, lexicon, [&](uint32_t i) {
+            DirectoryEntry e;
+            uint32_t df = (directory.find(lexicon.value(i), e) ? e.df : 0) + delta.df(lexicon.value(i));
+            if (best == SIZE_MAX || df > bestDf || (df == bestDf && i < best)) {
+                best = i;
+                bestDf = df;
             }
-        }
-        return bestMatch;
+        });
+        return best == SIZE_MAX ? "" : std::string(lexicon.key(best));
     }
 
     // --- Semantic Logic (Nearest Neighbor in Lexicon) [cite: 65, 67] ---
-    std::string findSemanticNeighbor(const std::string& word) {
-        if (wordVectors.find(word) == wordVectors.end()) return "";
-        std::string bestMatch = "";
-        float maxSim = -1.0f;
-        for (auto const& [lexWord, id] : lexicon) {
-            if (wordVectors.count(lexWord)) {
-                float sim = wordVectors[word].dot(wordVectors[lexWord]) /
-                            (wordVectors[word].magnitude() * wordVectors[lexWord].magnitude());
-                if (sim > maxSim && sim > 0.7) { // 0.7 Similarity Threshold
-                    maxSim = sim;
-                    bestMatch = lexWord;
-                }
-            }
+    // The lexicon word whose embedding is most similar to the word's, if
+    // above the threshold; approximate, from the HNSW graph
+    std::string findSemanticNeighbor(const std::string& word) const {
+        uint32_t row;
+        if (semanticIndex.empty() || !wordVectors.find(word, row)) return "";
+        for (const auto& [sim, node] : semanticIndex.search(wordVectors.row(row), 2)) {
+            if (sim <= semanticThreshold) break;
+            if (semanticRows[node] != row) return std::string(wordVectors.word(semanticRows[node]));
         }
-        return bestMatch;
+        return "";
+    }
+
+    // Graph over the lexicon words with a vector, redone whenever either side
+    // is reloaded. The cached graph is reused while the words it covers and
+    // the vectors file's size are unchanged.
+    void buildSemanticIndex() {
+        semanticRows.clear();
+        semanticIndex = HnswIndex();
+        if (wordVectors.empty()) return;
+        auto t0 = std::chrono::steady_clock::now();
+        uint32_t row;
+        for (size_t i = 0; i < lexicon.size(); ++i)
+            if (wordVectors.find(lexicon.key(i), row)) semanticRows.push_back(row);
+        if (semanticRows.empty()) return;
+
+        std::error_code ec;
+        uint64_t fingerprint = flat::hash({ reinterpret_cast<const char*>(semanticRows.data()),
+                                            semanticRows.size() * sizeof(uint32_t) }) ^
+                               (fs::file_size(wordVectorsPath, ec) * 0x9E3779B97F4A7C15ull);
+        VectorView view{ wordVectors.data(), wordVectors.dimensions(), semanticRows.data() };
+        uint32_t n = static_cast<uint32_t>(semanticRows.size());
+        std::string graphPath = wordVectorsPath + ".hnsw";
+        bool cached = semanticIndex.load(graphPath, view, n, fingerprint);
+        if (!cached) {
+            semanticIndex.build(view, n);
+            if (!semanticIndex.save(graphPath, fingerprint))
+                std::cerr << "[Engine][WARN] Cannot cache the semantic graph at " << graphPath << "\n";
+        }
+        std::cout << "[Engine] Semantic index: " << n << " of " << lexicon.size()
+                  << " lexicon words have a vector, graph " << (cached ? "loaded" : "built") << " in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count()
+                  << " ms\n";
     }
 
     // ===================== THREAD-SAFE POSTING FETCH =====================
 
-    InvertedList fetchPostingList(int wordID) {
-        InvertedList result;
-        int bID = wordID % TOTAL_BARRELS;
-        std::ifstream file(BARREL_DIR + "barrel_" + std::to_string(bID) + ".txt");
-        if (!file.is_open()) return result;
-        std::string line;
-        auto it = barrelIndex[bID].find(wordID);
-        if (it != barrelIndex[bID].end()) {
-            file.seekg(it->second);
-            std::getline(file, line);
-        }
-        if (line.empty() || line.rfind(std::to_string(wordID), 0) != 0) {
-            file.seekg(0);
-            while (std::getline(file, line)) {
-                std::stringstream ss(line);
-                int id; ss >> id;
-                if (id == wordID) break;
-                line.clear();
+    // Returns a mapping of barrel b covering at least `needed` bytes. If the
+    // file grew it is remapped; queries still holding the old mapping keep
+    // it alive until they finish.
+    std::shared_ptr<const MappedFile> barrelView(uint32_t b, uint64_t needed) {
+        {
+            std::shared_lock lock(barrelMapsMutex);
+            if (b >= barrelMaps.size()) return nullptr;
+            if (barrelMaps[b] && barrelMaps[b]->size() >= needed) return barrelMaps[b];
+        }
+        std::unique_lock lock(barrelMapsMutex);
+        auto& slot = barrelMaps[b];
+        if (slot && slot->size() >= needed) return slot;
+        auto fresh = std::make_shared<MappedFile>(BARREL_DIR + "barrel_" + std::to_string(b) + ".bin");
+        if (!fresh->isOpen() || fresh->size() < needed) return nullptr;
+        fresh->advise(MappedFile::Advice::Random);
+        slot = fresh;
+        return slot;
+    }
+
+    // A term's barrel record, read where it lies: in the posting cache or the
+    // barrel mapping. `owner` keeps the bytes alive.
+    struct RecordView {
+        const uint8_t* data = nullptr;
+        size_t length = 0;
+        std::shared_ptr<const void> owner;
+    };
+
+    bool termRecord(uint32_t wordID, RecordView& out) {
+        DirectoryEntry e;
+        if (!directory.find(wordID, e)) return false;
+        if (postingCache) {
+            if (auto cached = postingCache->get(wordID, e.barrel, e.offset)) {
+                out = { cached->data(), cached->size(), cached };
+                return true;
             }
         }
-        if (line.empty()) return result;
-        std::stringstream ss(line);
-        int id; ss >> id >> result.idf;
-        std::string colon; ss >> colon;
-        std::string token;
-        while (ss >> token) {
-            size_t p1 = token.find('(');
-            size_t p2 = token.find(',');
-            size_t p3 = token.find(')');
-            if (p1 == std::string::npos) continue;
-            DocEntry e;
-            e.docId = token.substr(0, p1);
-            e.tf = parseInt(token.substr(p1 + 1, p2 - p1 - 1));
-            e.mask = parseInt(token.substr(p2 + 1, p3 - p2 - 1));
-            result.docs.push_back(e);
+        auto map = barrelView(e.barrel, e.offset + e.length);
+        if (!map) return false;
+        out = { map->data() + e.offset, e.length, map };
+        if (postingCache) {
+            if (auto copy = postingCache->put(wordID, e.barrel, e.offset, out.data, out.length))
+                out = { copy->data(), copy->size(), copy };
+        }
+        return true;
+    }
+
+    InvertedList fetchPostingList(int wordID, bool withPositions = false) {
+        InvertedList result;
+        RecordView rec;
+        if (!termRecord(static_cast<uint32_t>(wordID), rec)) {
+            appendDelta(result, static_cast<uint32_t>(wordID), withPositions);
+            return result;
+        }
+
+        // Decode in place; the header check rejects a stale or torn entry
+        PostingHeader h;
+        bool ok = PostingCodec::decodeWithPositions(rec.data, rec.length, h, withPositions,
+            [&](uint32_t doc, uint32_t tf, int mask, uint8_t impact, const uint32_t* pos, size_t n) {
+                result.docs.push_back({ doc, tf, mask });
+                result.docIds.push_back(doc);
+                if (h.impacts) result.impacts.push_back(impact);
+                if (!pos) return;
+                if (result.positionStart.empty()) result.positionStart.push_back(0);
+                result.positions.insert(result.positions.end(), pos, pos + n);
+                result.positionStart.push_back(static_cast<uint32_t>(result.positions.size()));
+            });
+        if (!ok || h.wordID != static_cast<uint32_t>(wordID)) return {};
+        if (result.positionStart.size() != result.docs.size() + 1) {
+            result.positions.clear();
+            result.positionStart.clear();
         }
+        result.idf = h.idf;
+        result.df = h.df;
+        appendDelta(result, static_cast<uint32_t>(wordID), withPositions);
         return result;
     }
 
-    std::vector<json> runStrictAND(std::vector<TermInfo>& terms) {
-        std::unordered_map<std::string, double> scores;
+    // Appends the term's added postings to its decoded barrel record (or to
+    // an empty list). Positions are kept only if both sides have them. The
+    // stored impacts were quantized for the old df, so the whole list is
+    // scored on the fly instead, and the idf is recomputed for the new one.
+    void appendDelta(InvertedList& list, uint32_t wordID, bool withPositions) const {
+        const DeltaPostings::Term* t = delta.find(wordID);
+        if (!t) return;
+        bool hadDocs = !list.docs.empty();
+        uint32_t last = hadDocs ? list.docIds.back() : 0;
+        bool positions = withPositions && t->positional && (!hadDocs || list.hasPositions());
+        if (!positions) {
+            list.positions.clear();
+            list.positionStart.clear();
+        } else if (list.positionStart.empty()) {
+            list.positionStart.push_back(0);
+        }
+        const auto& added = t->list.postings;
+        uint32_t offset = 0;
+        for (const Posting& p : added) {
+            uint32_t start = offset;
+            if (t->positional) offset += p.tf;
+            if (hadDocs && p.docId <= last) continue; // already folded into the record
+            list.docs.push_back({ p.docId, p.tf, p.mask });
+            list.docIds.push_back(p.docId);
+            if (!positions) continue;
+            list.positions.insert(list.positions.end(), t->list.positions.begin() + start,
+                                  t->list.positions.begin() + offset);
+            list.positionStart.push_back(static_cast<uint32_t>(list.positions.size()));
+        }
+        list.impacts.clear();
+        list.df = static_cast<uint32_t>(list.docs.size());
+        list.idf = std::log(static_cast<double>(docTable.size() > 1 ? docTable.size() - 1 : 1) / list.df);
+    }
+
+    // ===================== PHRASES =====================
+
+    // Splits a query into free text and quoted phrases ("..." or "..."~k).
+    // An unterminated quote runs to the end of the query.
+    struct QueryPart {
+        std::string_view text;
+        bool quoted;
+        Phrase phrase;
+    };
+
+    static std::vector<QueryPart> splitQuery(std::string_view q) {
+        std::vector<QueryPart> parts;
+        size_t i = 0;
+        while (i < q.size()) {
+            size_t open = q.find('"', i);
+            if (open == std::string_view::npos) {
+                parts.push_back({ q.substr(i), false, {} });
+                break;
+            }
+            if (open > i) parts.push_back({ q.substr(i, open - i), false, {} });
+            size_t close = q.find('"', open + 1);
+            QueryPart part{ q.substr(open + 1, close == std::string_view::npos ? close : close - open - 1), true, {} };
+            i = close == std::string_view::npos ? q.size() : close + 1;
+            if (i < q.size() && q[i] == '~') {
+                uint32_t k = 0;
+                for (++i; i < q.size() && q[i] >= '0' && q[i] <= '9'; ++i)
+                    k = std::min<uint32_t>(k * 10 + (q[i] - '0'), MAX_SLOP);
+                part.phrase.ordered = false;
+                part.phrase.slop = k;
+            }
+            parts.push_back(part);
+        }
+        return parts;
+    }
+
+    // Checks one phrase against a document using the positions of its terms
+    bool phraseMatches(const std::vector<TermInfo>& terms, int phrase, const Phrase& ph, uint32_t doc) {
+        std::vector<std::pair<const uint32_t*, const uint32_t*>> lists(ph.length);
+        for (const auto& t : terms) {
+            if (t.phrase != phrase) continue;
+            const auto& docs = t.list.docs;
+            auto it = std::lower_bound(docs.begin(), docs.end(), doc,
+                                       [](const DocEntry& e, uint32_t d) { return e.docId < d; });
+            if (it == docs.end() || it->docId != doc || !t.list.hasPositions()) return false;
+            size_t i = static_cast<size_t>(it - docs.begin());
+            const uint32_t* base = t.list.positions.data();
+            lists[t.phraseOffset] = { base + t.list.positionStart[i], base + t.list.positionStart[i + 1] };
+        }
+
+        if (ph.ordered) {
+            // Word i of the phrase must sit exactly i positions after word 0
+            for (const uint32_t* p = lists[0].first; p != lists[0].second; ++p) {
+                bool all = true;
+                for (size_t i = 1; i < lists.size() && all; ++i)
+                    all = std::binary_search(lists[i].first, lists[i].second, *p + static_cast<uint32_t>(i));
+                if (all) return true;
+            }
+            return false;
+        }
+
+        // Smallest window holding one position of every word: advance the list
+        // at the current minimum until one list runs out
+        uint32_t window = static_cast<uint32_t>(ph.length - 1) + ph.slop;
+        while (true) {
+            size_t minList = 0;
+            uint32_t lo = UINT32_MAX, hi = 0;
+            for (size_t i = 0; i < lists.size(); ++i) {
+                if (lists[i].first == lists[i].second) return false;
+                uint32_t v = *lists[i].first;
+                if (v < lo) { lo = v; minList = i; }
+                hi = std::max(hi, v);
+            }
+            if (hi - lo <= window) return true;
+            ++lists[minList].first;
+        }
+    }
+
+    // AND over the doc-sorted posting arrays. Candidates start as the first
+    // (shortest) list and are intersected with each further list in place,
+    // adding that term's score to every survivor as it is matched. Each list
+    // takes part with its first MAX_DOCS_PER_TERM postings.
+    std::vector<SearchResult> intersectTerms(const std::vector<TermInfo>& terms, const Scorer& sc,
+                                             size_t* scored = nullptr) {
+        std::vector<SearchResult> cand;
+        std::vector<uint32_t> ids;
+        if (terms.empty()) return cand;
+
+        const InvertedList& first = terms[0].list;
+        size_t limit = std::min(first.docs.size(), MAX_DOCS_PER_TERM);
+        if (scored) *scored += limit;
+        cand.reserve(limit);
+        ids.assign(first.docIds.begin(), first.docIds.begin() + limit);
+        double w0 = sc.weight(first.idf, first.df);
+        for (size_t i = 0; i < limit; ++i) cand.push_back({ ids[i], sc.score(first, i, w0) });
+
+        for (size_t t = 1; t < terms.size() && !cand.empty(); ++t) {
+            const InvertedList& list = terms[t].list;
+            size_t n = std::min(list.docs.size(), MAX_DOCS_PER_TERM);
+            size_t kept = 0;
+            double w = sc.weight(list.idf, list.df);
+            intersect::intersect(ids.data(), ids.size(), list.docIds.data(), n, [&](size_t i, size_t j) {
+                ids[kept] = ids[i];
+                cand[kept] = { cand[i].docId, cand[i].score + sc.score(list, j, w) };
+                ++kept;
+            });
+            ids.resize(kept);
+            cand.resize(kept);
+            if (scored) *scored += kept;
+        }
+        return cand;
+    }
+
+    // ===================== BLOCK-MAX TOP-K =====================
+
+    // One cursor per term over its barrel record, capped at MAX_DOCS_PER_TERM;
+    // false if any term has no valid record
+    bool openCursors(const std::vector<TermInfo>& terms, std::vector<RecordView>& records,
+                     std::vector<PostingCursor>& cursors) {
+        records.assign(terms.size(), {});
+        cursors.assign(terms.size(), {});
+        for (size_t i = 0; i < terms.size(); ++i) {
+            if (!termRecord(static_cast<uint32_t>(terms[i].wordID), records[i]) ||
+                !cursors[i].open(records[i].data, records[i].length, MAX_DOCS_PER_TERM) ||
+                cursors[i].header().wordID != static_cast<uint32_t>(terms[i].wordID))
+                return false;
+        }
+        return !terms.empty();
+    }
+
+    // Adds r to a top-k min-heap (worst result on top) if it places
+    static void offer(std::vector<SearchResult>& heap, size_t k, const SearchResult& r) {
+        if (heap.size() < k) {
+            heap.push_back(r);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>());
+        } else if (r > heap.front()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+            heap.back() = r;
+            std::push_heap(heap.begin(), heap.end(), std::greater<>());
+        }
+    }
+
+    // Top-k of the AND of all terms without decoding or scoring blocks that
+    // cannot place: the conjunctive form of Block-Max WAND. Cursors walk the
+    // records in place; at each candidate the block maxima of all terms are
+    // summed, and if that bound cannot beat the current k-th score every
+    // cursor's block is skipped up to the nearest block end. Candidates are
+    // visited in doc order and ties go to the lower doc ID, so a later doc
+    // needs a strictly higher score; sums are taken in term order on both
+    // sides, so the bound never undercuts a real score. Results equal the
+    // exhaustive path's.
+    // With `after`, only results ranking after it are kept.
+    std::vector<SearchResult> blockMaxTopK(const std::vector<TermInfo>& terms, size_t k, const Scorer& sc,
+                                           const PageCursor* after = nullptr,
+                                           size_t* scored = nullptr, size_t* blocksDecoded = nullptr) {
+        std::vector<SearchResult> heap; // worst result on top
+        std::vector<RecordView> records;
+        std::vector<PostingCursor> cursors;
+        if (k == 0 || !openCursors(terms, records, cursors)) return heap;
+        std::vector<double> weights;
+        for (auto& c : cursors) weights.push_back(sc.weight(c.header().idf, c.header().df));
+
+        const uint32_t END = PostingCursor::END;
+        PostingCursor& lead = cursors[0];
+        uint32_t doc = lead.seek(0);
+        while (doc != END) {
+            if (heap.size() == k) {
+                double bound = 0.0;
+                uint32_t boundary = END;
+                for (auto& c : cursors) {
+                    c.shallowSeek(doc);
+                    bound += sc.bound(c);
+                    boundary = std::min(boundary, c.blockLastDoc());
+                }
+                if (boundary == END) break; // some list has no blocks left
+                if (bound <= heap.front().score) {
+                    doc = lead.seek(boundary + 1);
+                    continue;
+                }
+            }
+
+            // Align every cursor on doc; a miss moves the lead past it
+            uint32_t next = doc;
+            for (size_t i = 1; i < cursors.size() && next == doc; ++i)
+                next = cursors[i].seek(doc);
+            if (next != doc) {
+                doc = next == END ? END : lead.seek(next);
+                continue;
+            }
+
+            double total = 0.0;
+            for (size_t t = 0; t < cursors.size(); ++t) total += sc.score(cursors[t], weights[t]);
+            if (scored) *scored += cursors.size();
+            SearchResult r{ doc, total };
+            if (docTable.has(doc) && (!after || after->admits(r))) offer(heap, k, r);
+            doc = lead.next();
+        }
+
+        if (blocksDecoded)
+            for (auto& c : cursors) *blocksDecoded += c.decodedBlockCount();
+        std::sort_heap(heap.begin(), heap.end(), std::greater<>());
+        return heap;
+    }
+
+    // The hash-map AND that intersectTerms replaced; kept as the reference
+    // for benchmarkIntersection()
+    std::vector<SearchResult> hashIntersectTerms(const std::vector<TermInfo>& terms, const Scorer& sc) {
+        std::unordered_map<uint32_t, double> scores;
         bool first = true;
         for (auto& t : terms) {
             size_t limit = std::min(t.list.docs.size(), MAX_DOCS_PER_TERM);
-            std::unordered_map<std::string, const DocEntry*> lookup;
+            double w = sc.weight(t.list.idf, t.list.df);
+            std::unordered_map<uint32_t, size_t> lookup;
             for (size_t i = 0; i < limit; ++i)
-                lookup[t.list.docs[i].docId] = &t.list.docs[i];
+                lookup[t.list.docs[i].docId] = i;
             if (first) {
-                for (auto& [id, e] : lookup) scores[id] = score(*e, t.list.idf);
+                for (auto& [id, i] : lookup) scores[id] = sc.score(t.list, i, w);
                 first = false;
             } else {
                 for (auto it = scores.begin(); it != scores.end(); ) {
                     auto f = lookup.find(it->first);
                     if (f == lookup.end()) it = scores.erase(it);
-                    else { it->second += score(*f->second, t.list.idf); ++it; }
+                    else { it->second += sc.score(t.list, f->second, w); ++it; }
                 }
             }
             if (scores.empty()) break;
         }
-        return finalize(scores);
+        std::vector<SearchResult> out;
+        out.reserve(scores.size());
+        for (auto& [doc, total] : scores) out.push_back({ doc, total });
+        return out;
     }
 
-    std::vector<json> finalize(std::unordered_map<std::string, double>& scores) {
-        std::vector<SearchResult> results;
-        for (auto& [doc, sc] : scores) {
-            if (!docTable.count(doc)) continue;
-            results.push_back({ doc, sc, docTable.at(doc) });
-        }
-        if (results.empty()) return {};
-        size_t k = std::min<size_t>(10, results.size());
-        std::partial_sort(results.begin(), results.begin() + k, results.end(), std::greater<>());
-        std::ifstream raw(rawDatasetPath, std::ios::binary);
-        std::vector<json> out;
-        for (size_t i = 0; i < k; ++i) {
-            raw.seekg(results[i].meta.offset);
-            std::vector<char> buf(results[i].meta.length);
-            raw.read(buf.data(), buf.size());
-            try {
-                json j = json::parse(std::string(buf.begin(), buf.end()));
-                j["relevance_score"] = results[i].score;
-                out.push_back(j);
-            } catch (...) {}
+    // ===================== QUORUM SCORING =====================
+
+    // The top-k at the highest quorum level with hits, in one pass over the
+    // decoded lists. Level L requires every phrase term (with all phrases
+    // matching) plus the L shortest free terms, so levels are prefixes of
+    // `order`: phrase terms, then free terms, each shortest first. Candidates
+    // are intersected with one more term per level and stay at the last level
+    // that kept any; this is what dropping the longest list and retrying did.
+    // Each candidate keeps its per-term scores, summed at the end in `terms`
+    // order so totals equal intersectTerms' for that level.
+    std::vector<SearchResult> quorumTopK(const std::vector<TermInfo>& terms, const std::vector<Phrase>& phrases,
+                                         size_t k, const Scorer& sc, const PageCursor* after = nullptr) {
+        size_t n = terms.size();
+        std::vector<size_t> order;
+        for (size_t t = 0; t < n; ++t)
+            if (!phrases.empty() && terms[t].phrase >= 0) order.push_back(t);
+        size_t required = order.size();
+        for (size_t t = 0; t < n; ++t)
+            if (phrases.empty() || terms[t].phrase < 0) order.push_back(t);
+        if (order.empty()) return {};
+
+        std::vector<uint32_t> ids;
+        std::vector<double> parts; // n per candidate, 0 for terms outside its level
+        const InvertedList& first = terms[order[0]].list;
+        size_t limit = std::min(first.docs.size(), MAX_DOCS_PER_TERM);
+        double w0 = sc.weight(first.idf, first.df);
+        for (size_t i = 0; i < limit; ++i) {
+            if (!docTable.has(first.docIds[i])) continue;
+            ids.push_back(first.docIds[i]);
+            parts.resize(parts.size() + n, 0.0);
+            parts[parts.size() - n + order[0]] = sc.score(first, i, w0);
         }
+
+        // Keeps the candidates for which keep(c) holds, in order
+        auto compact = [&](auto&& keep) {
+            size_t kept = 0;
+            for (size_t c = 0; c < ids.size(); ++c) {
+                if (!keep(c)) continue;
+                if (kept != c) {
+                    ids[kept] = ids[c];
+                    std::copy_n(parts.begin() + c * n, n, parts.begin() + kept * n);
+                }
+                ++kept;
+            }
+            ids.resize(kept);
+            parts.resize(kept * n);
+        };
+        auto phrasesMatch = [&](size_t c) {
+            for (size_t p = 0; p < phrases.size(); ++p)
+                if (!phraseMatches(terms, static_cast<int>(p), phrases[p], ids[c])) return false;
+            return true;
+        };
+
+        std::vector<std::pair<size_t, size_t>> matches;
+        for (size_t level = 1; level < order.size() && !ids.empty(); ++level) {
+            const InvertedList& list = terms[order[level]].list;
+            double w = sc.weight(list.idf, list.df);
+            matches.clear();
+            intersect::intersect(ids.data(), ids.size(), list.docIds.data(),
+                                 std::min(list.docs.size(), MAX_DOCS_PER_TERM),
+                                 [&](size_t i, size_t j) { matches.emplace_back(i, j); });
+            if (matches.empty() && level >= required) break; // no one reaches this level
+
+            size_t next = 0;
+            compact([&](size_t c) {
+                if (next == matches.size() || matches[next].first != c) return false;
+                parts[c * n + order[level]] = sc.score(list, matches[next++].second, w);
+                return true;
+            });
+            if (level + 1 == required) compact(phrasesMatch);
+        }
+
+        std::vector<SearchResult> results(ids.size());
+        for (size_t c = 0; c < ids.size(); ++c) {
+            double total = 0.0;
+            for (size_t t = 0; t < n; ++t) total += parts[c * n + t];
+            results[c] = { ids[c], total };
+        }
+        return topK(results, k, after);
+    }
+
+    // quorumTopK() without phrases, read in place from the barrels: the
+    // shortest list is walked once and each of its docs is matched against
+    // the next lists in order for as long as it hits, which gives its level.
+    // Only docs at the highest level seen so far are scored (over that
+    // level's terms) and kept; the heap restarts when the level rises.
+    std::vector<SearchResult> quorumCursorTopK(const std::vector<TermInfo>& terms, size_t k, const Scorer& sc,
+                                               const PageCursor* after = nullptr) {
+        std::vector<SearchResult> heap;
+        std::vector<RecordView> records;
+        std::vector<PostingCursor> cursors;
+        if (k == 0 || !openCursors(terms, records, cursors)) return heap;
+        std::vector<double> weights;
+        for (auto& c : cursors) weights.push_back(sc.weight(c.header().idf, c.header().df));
+
+        size_t level = 0;
+        PostingCursor& lead = cursors[0];
+        for (uint32_t doc = lead.seek(0); doc != PostingCursor::END; doc = lead.next()) {
+            if (!docTable.has(doc)) continue;
+            size_t reached = 1;
+            while (reached < cursors.size() && cursors[reached].seek(doc) == doc) ++reached;
+            if (reached < level) continue;
+            if (reached > level) {
+                level = reached;
+                heap.clear();
+            }
+            double total = 0.0;
+            for (size_t t = 0; t < level; ++t) total += sc.score(cursors[t], weights[t]);
+            SearchResult r{ doc, total };
+            if (!after || after->admits(r)) offer(heap, k, r);
+        }
+        std::sort_heap(heap.begin(), heap.end(), std::greater<>());
+        return heap;
+    }
+
+    // Best k of the scored candidates that are in the doc table (and rank
+    // after `after`), through a k-bounded heap, best first
+    std::vector<SearchResult> topK(const std::vector<SearchResult>& results, size_t k,
+                                   const PageCursor* after = nullptr) {
+        std::vector<SearchResult> heap;
+        if (k == 0) return heap;
+        heap.reserve(std::min(k, results.size()));
+        for (const auto& r : results)
+            if (docTable.has(r.docId) && (!after || after->admits(r))) offer(heap, k, r);
+        std::sort_heap(heap.begin(), heap.end(), std::greater<>());
+        return heap;
+    }
+
+    // Serializes the ranked documents as a JSON array of their result fields
+    // plus relevance_score. Fields are copied from the doc store; documents it
+    // does not hold (added since the build, or no store) are read from the
+    // raw dataset and their fields extracted without a DOM.
+    std::string render(const std::vector<SearchResult>& results) {
+        std::string out = "[";
+        std::ifstream raw;
+        std::string line;
+        for (const auto& r : results) {
+            size_t start = out.size();
+            out += start > 1 ? ",{" : "{";
+            bool ok = docStore.appendFields(r.docId, out);
+            if (!ok) {
+                if (!raw.is_open()) raw.open(rawDatasetPath, std::ios::binary);
+                line.resize(docTable.length(r.docId));
+                raw.clear();
+                raw.seekg(static_cast<std::streamoff>(docTable.offset(r.docId)));
+                ok = raw.read(line.data(), line.size()) && DocStore::extractFields(line, out);
+            }
+            if (!ok) {
+                out.resize(start);
+                continue;
+            }
+            out += ",\"relevance_score\":";
+            out += json(r.score).dump();
+            out += '}';
+        }
+        out += ']';
         return out;
     }
 
 public:
     void setDatasetPath(const std::string& p) { rawDatasetPath = p; }
+
+    // Maps the doc store written by the index build; without it results are
+    // read from the raw dataset
+    bool loadDocStore(const std::string& p) {
+        if (docStore.open(p)) return true;
+        std::cerr << "[Engine][WARN] No doc store at " << p << ", serving results from the raw dataset\n";
+        return false;
+    }
+    // Maps the document length column written by the index build; BM25 and
+    // impact ranking need it and otherwise fall back to tf-idf
+    bool loadDocLengths(const std::string& p) {
+        if (docLengths.open(p)) return true;
+        std::cerr << "[Engine][WARN] No doc lengths at " << p << ", ranking with tf-idf\n";
+        return false;
+    }
+
+    // Maps the document embeddings written by writeDocVectors and loads (or
+    // builds) their graph
+    bool loadDocVectors(const std::string& p) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (!docVectors.open(p)) {
+            std::cerr << "[Engine][WARN] No document vectors at " << p << ", /semantic off\n";
+            return false;
+        }
+        std::cout << "[Engine] " << docVectors.indexed() << " document vectors of dimension "
+                  << docVectors.dimensions() << " ready in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count()
+                  << " ms\n";
+        return true;
+    }
+
+    // Converts precomputed document embeddings, one "<original ID> <v1> ...
+    // <vdim>" line per document (see sample_semantic.py), to the doc vector
+    // file, by internal doc ID; needs the doc map. Rows are written as they
+    // are read, so the matrix is never held in memory. Lines for unknown
+    // documents, and zero vectors, are skipped.
+    bool writeDocVectors(const std::string& textPath, const std::string& outPath) {
+        std::ifstream in(textPath);
+        if (!in.is_open()) {
+            std::cerr << "[Engine][ERROR] Cannot open embeddings: " << textPath << "\n";
+            return false;
+        }
+        DocVectors::Writer out;
+        uint32_t dim = 0;
+        size_t written = 0, skipped = 0;
+        std::string line, id;
+        std::vector<float> v;
+        while (std::getline(in, line)) {
+            std::stringstream ss(line);
+            if (!(ss >> id)) continue;
+            v.clear();
+            for (float x; ss >> x; ) v.push_back(x);
+            if (dim == 0 && !v.empty()) {
+                dim = static_cast<uint32_t>(v.size());
+                if (!out.open(outPath, static_cast<uint32_t>(docTable.size()), dim)) break;
+            }
+            uint32_t doc;
+            if (!findDoc(id, doc) || v.size() != dim || dim == 0 || !out.put(doc, v.data())) {
+                ++skipped;
+                continue;
+            }
+            ++written;
+        }
+        if (!out.close() || written == 0) {
+            std::cerr << "[Engine][ERROR] No document vectors written to " << outPath << "\n";
+            return false;
+        }
+        std::cout << "[Engine] " << written << " document vectors of dimension " << dim << " written to "
+                  << outPath << " (" << skipped << " lines skipped)\n";
+        return true;
+    }
+
+    // Word embeddings for the semantic fallback (see WordVectors.hpp); the
+    // first maxWords of the file, all if 0. Load after the lexicon.
+    bool loadWordVectors(const std::string& p, size_t maxWords = 0) {
+        wordVectorsPath = p;
+        if (!wordVectors.load(p, maxWords)) {
+            std::cerr << "[Engine][WARN] No word vectors at " << p << ", semantic fallback off\n";
+            buildSemanticIndex();
+            return false;
+        }
+        std::cout << "[Engine] " << wordVectors.size() << " word vectors of dimension "
+                  << wordVectors.dimensions() << " (" << (wordVectors.byteSize() >> 20) << " MB)\n";
+        buildSemanticIndex();
+        return true;
+    }
+    // Cosine similarity a semantic neighbour must exceed, 0.7 by default
+    void setSemanticThreshold(float t) { semanticThreshold = t; }
+
+    // Ranking for queries that do not choose one; false (and unchanged) if it
+    // needs doc lengths and none are loaded
+    bool setRanking(Ranking r) {
+        if (r != Ranking::TfIdf && !docLengths.isOpen()) {
+            std::cerr << "[Engine][WARN] " << ranking::name(r) << " ranking needs doc lengths\n";
+            return false;
+        }
+        defaultRanking = r;
+        return true;
+    }
+
+    // Exhaustive mode decodes and scores every candidate; for testing the
+    // block-max evaluator, which must return the same results
+    void setExhaustive(bool on) { exhaustive = on; }
+
+    // Keeps up to budgetBytes of the most frequently queried barrel records
+    // in memory; 0 turns the posting cache off. Set before serving queries.
+    void setPostingCacheBudget(size_t budgetBytes) {
+        postingCache = budgetBytes ? std::make_unique<PostingCache>(budgetBytes) : nullptr;
+    }
+    PostingCache::Stats postingCacheStats() const {
+        return postingCache ? postingCache->stats() : PostingCache::Stats{};
+    }
     void loadLexicon(const std::string& p) {
         std::ifstream f(p);
         std::string w; int id;
-        while (f >> w >> id) lexicon[w] = id;
+        std::unordered_map<std::string, uint32_t> words; // a repeated word keeps its last ID
+        while (f >> w >> id) words[w] = static_cast<uint32_t>(id);
+        std::vector<std::pair<std::string, uint32_t>> items(words.begin(), words.end());
+        std::sort(items.begin(), items.end(), [](auto& a, auto& b) { return a.second < b.second; });
+        lexicon.assign(StringTable::build(items));
+        spelling.build(lexicon);
+        buildSemanticIndex();
     }
     void loadDocMap(const std::string& p) {
         std::ifstream f(p);
         std::string line; std::getline(f, line);
+        std::vector<DocMetadata> docs;
         while (std::getline(f, line)) {
             std::stringstream ss(line);
             std::string seg; std::vector<std::string> v;
             while (std::getline(ss, seg, '|')) v.push_back(seg);
-            if (v.size() >= 4) docTable[v[1]] = { v[0], parseLong(v[2]), parseLong(v[3]) };
+            if (v.size() < 4) continue;
+            size_t internal = static_cast<size_t>(parseLong(v[0]));
+            if (internal >= docs.size()) docs.resize(internal + 1);
+            docs[internal] = { v[1], parseLong(v[2]), parseLong(v[3]) };
+        }
+        docTable.assign(DocTable::build(docs));
+        indexDocIds();
+    }
+
+    // Original ID -> internal ID over the doc table, for lookups by document
+    void indexDocIds() {
+        std::vector<std::pair<std::string, uint32_t>> items;
+        for (uint32_t d = 0; d < docTable.size(); ++d)
+            if (docTable.has(d)) items.emplace_back(docTable.externalId(d), d);
+        docIndex.assign(StringTable::build(items));
+    }
+
+    // ===================== SNAPSHOT =====================
+
+    void saveSnapshot(SnapshotWriter& w) const {
+        w.add(SnapshotSection::Lexicon, lexicon.data(), lexicon.byteSize());
+        w.add(SnapshotSection::DocTable, docTable.data(), docTable.byteSize());
+        w.add(SnapshotSection::DocIds, docIndex.data(), docIndex.byteSize());
+        w.add(SnapshotSection::Spelling, spelling.data(), spelling.byteSize());
+    }
+
+    // Points the lexicon, doc table, doc ID index and spelling index at the
+    // image's sections; nothing is copied. An image without the last two gets
+    // them built. The semantic graph comes from its own cache file.
+    bool loadSnapshot(std::shared_ptr<const SnapshotImage> image) {
+        const uint8_t* p;
+        size_t n;
+        if (!image->section(SnapshotSection::Lexicon, p, n) || !lexicon.attach(p, n) ||
+            !image->section(SnapshotSection::DocTable, p, n) || !docTable.attach(p, n)) {
+            std::cerr << "[Engine][ERROR] Snapshot is missing the lexicon or doc table\n";
+            lexicon = StringTable();
+            docTable = DocTable();
+            docIndex = StringTable();
+            spelling = SpellIndex();
+            buildSemanticIndex();
+            return false;
         }
+        if (!image->section(SnapshotSection::DocIds, p, n) || !docIndex.attach(p, n)) indexDocIds();
+        if (!image->section(SnapshotSection::Spelling, p, n) || !spelling.attach(p, n)) spelling.build(lexicon);
+        snapshot = std::move(image);
+        buildSemanticIndex();
+        return true;
     }
-    void loadBarrels() {
-        for (int i = 0; i < TOTAL_BARRELS; ++i) {
-            std::ifstream idx(BARREL_DIR + "barrel_" + std::to_string(i) + ".idx");
-            int w; long long o;
-            while (idx >> w >> o) barrelIndex[i][w] = o;
+
+    // Maps the term directory and every barrel; nothing is parsed. With
+    // preload the kernel is asked to read all barrels ahead; otherwise
+    // access is marked random. The postings of added documents are read
+    // into memory.
+    void loadBarrels(bool preload = false) {
+        delta.clear();
+        if (!delta.refresh(BARREL_DIR + "delta.bin"))
+            std::cerr << "[Engine][ERROR] Invalid delta.bin in " << BARREL_DIR << "\n";
+        if (!routing.load(BARREL_DIR)) {
+            std::cerr << "[Engine][ERROR] Missing barrel routing table in " << BARREL_DIR << "\n";
+            return;
+        }
+        if (!directory.open(BARREL_DIR + "directory.bin")) {
+            std::cerr << "[Engine][ERROR] Missing or invalid directory.bin in " << BARREL_DIR << "\n";
+            return;
+        }
+        std::unique_lock lock(barrelMapsMutex);
+        barrelMaps.assign(routing.barrelCount(), nullptr);
+        for (size_t i = 0; i < routing.barrelCount(); ++i) {
+            std::string path = BARREL_DIR + "barrel_" + std::to_string(i) + ".bin";
+            auto map = std::make_shared<MappedFile>(path);
+            if (!map->isOpen()) {
+                std::cerr << "[Engine][ERROR] Cannot map " << path << "\n";
+                continue;
+            }
+            map->advise(preload ? MappedFile::Advice::WillNeed : MappedFile::Advice::Random);
+            barrelMaps[i] = map;
         }
     }
 
+    // Hint that these terms' postings will be needed soon (e.g. the most
+    // frequent query terms), so their pages are read ahead.
+    void adviseHotTerms(const std::vector<std::string>& terms) {
+        for (const auto& t : terms) {
+            uint32_t wid;
+            DirectoryEntry e;
+            if (!lexicon.find(t, wid) || !directory.find(wid, e)) continue;
+            if (auto map = barrelView(e.barrel, e.offset + e.length))
+                map->advise(MappedFile::Advice::WillNeed, e.offset, e.length);
+        }
+    }
+
+private:
     // ===================== SEARCH WITH SEMANTIC/SPELLING =====================
 
-    std::vector<json> search(const std::string& query) {
-        std::stringstream qs(query);
-        std::string term;
-        std::vector<TermInfo> terms;
+    // Sorts the resolved terms by list length. With `decode` (forced on for
+    // queries with phrases, and set to what was done) the postings are fetched
+    // and decoded; otherwise only their document counts are read from the
+    // directory. Returns whether the phrase constraints can be checked, i.e.
+    // the phrase terms have positions.
+    bool loadTerms(std::vector<TermInfo>& terms, const std::vector<Phrase>& phrases, bool& decode) {
+        if (terms.empty()) return false;
+
+        // Block-max cursors walk barrel records only, so terms with added
+        // postings are decoded
+        decode = decode || !phrases.empty();
+        for (const auto& t : terms)
+            if (delta.df(static_cast<uint32_t>(t.wordID)) > 0) decode = true;
+        if (!decode) {
+            for (auto& t : terms) {
+                DirectoryEntry e;
+                t.docCount = directory.find(static_cast<uint32_t>(t.wordID), e) ? e.df : 0;
+            }
+            std::sort(terms.begin(), terms.end(), [](auto& a, auto& b) { return a.docCount < b.docCount; });
+            return false;
+        }
+
+        fetchLists(terms);
+        for (auto& t : terms) t.docCount = t.list.docs.size();
+
+        // Without positions in the index, phrases fall back to plain terms
+        bool phrasesOn = !phrases.empty();
+        for (const auto& t : terms)
+            if (t.phrase >= 0 && t.docCount > 0 && !t.list.hasPositions()) phrasesOn = false;
+
+        std::sort(terms.begin(), terms.end(), [](auto& a, auto& b) { return a.docCount < b.docCount; });
+        return phrasesOn;
+    }
+
+    // Fetches and decodes every term's postings in parallel; phrase terms get
+    // their positions
+    void fetchLists(std::vector<TermInfo>& terms) {
         std::vector<std::future<InvertedList>> futures;
+        for (const auto& t : terms)
+            futures.push_back(std::async(std::launch::async, &SearchEngine::fetchPostingList, this,
+                                         t.wordID, t.phrase >= 0));
+        for (size_t i = 0; i < terms.size(); ++i) terms[i].list = futures[i].get();
+    }
 
-        while (qs >> term) {
-            std::transform(term.begin(), term.end(), term.begin(), ::tolower);
-            if (STOPWORDS.count(term)) continue;
+    // parseQuery() then loadTerms(), for the benchmarks
+    bool prepareTerms(const std::string& query, std::vector<TermInfo>& terms, std::vector<Phrase>& phrases,
+                      bool& decode) {
+        ParsedQuery parsed = parseQuery(query);
+        terms = std::move(parsed.terms);
+        phrases = std::move(parsed.phrases);
+        return loadTerms(terms, phrases, decode);
+    }
 
-            std::string processedTerm = "";
+public:
+    // Resolves the query's words (spelling and semantic fallbacks) and its
+    // phrases, in query order; nothing is read from the barrels. Without
+    // doc lengths the ranking is always tf-idf.
+    ParsedQuery parseQuery(const std::string& query) { return parseQuery(query, defaultRanking); }
 
+    ParsedQuery parseQuery(const std::string& query, Ranking r) {
+        ParsedQuery parsed;
+        parsed.ranking = scorerFor(r).mode;
+        auto& terms = parsed.terms;
+        auto& phrases = parsed.phrases;
+        auto resolve = [&](const std::string& term) {
             // 1. Check Lexicon [cite: 52]
-            if (lexicon.count(term)) {
-                processedTerm = term;
-            }
+            if (lexicon.contains(term)) return term;
             // 2. Try Spelling Correction if not in Lexicon [cite: 66]
-            else {
-                processedTerm = findCorrection(term);
-                // 3. Try Semantic Fallback if no spelling match [cite: 65, 67]
-                if (processedTerm.empty()) {
-                    processedTerm = findSemanticNeighbor(term);
-                }
+            std::string processedTerm = findCorrection(term);
+            // 3. Try Semantic Fallback if no spelling match [cite: 65, 67]
+            if (processedTerm.empty()) processedTerm = findSemanticNeighbor(term);
+            return processedTerm;
+        };
+
+        // Same normalization as indexing; index stop words are already dropped
+        Tokenizer queryTokens;
+        for (const QueryPart& part : splitQuery(query)) {
+            size_t firstTerm = terms.size();
+            bool complete = true;
+            for (std::string_view token : queryTokens.tokenize(part.text)) {
+                std::string term(token);
+                // Inside a phrase every indexed word counts toward adjacency
+                if (!part.quoted && STOPWORDS.count(term)) continue;
+
+                std::string processedTerm = resolve(term);
+
+                // 4. Drop word if all methods fail
+                if (processedTerm.empty()) { complete = false; continue; }
+
+                uint32_t wid = 0;
+                lexicon.find(processedTerm, wid);
+                terms.push_back({ processedTerm, static_cast<int>(wid), 0, {} });
             }
 
-            // 4. Drop word if all methods fail
-            if (processedTerm.empty()) continue;
+            // A phrase with a dropped word can no longer match by position
+            size_t length = terms.size() - firstTerm;
+            bool phrase = part.quoted && complete && length >= 2;
+            if (phrase) {
+                for (size_t i = firstTerm; i < terms.size(); ++i) {
+                    terms[i].phrase = static_cast<int>(phrases.size());
+                    terms[i].phraseOffset = static_cast<uint32_t>(i - firstTerm);
+                }
+                Phrase ph = part.phrase;
+                ph.length = length;
+                phrases.push_back(ph);
+            }
 
-            int wid = lexicon[processedTerm];
-            futures.push_back(std::async(std::launch::async, &SearchEngine::fetchPostingList, this, wid));
-            terms.push_back({ processedTerm, wid, 0, {} });
+            // Words are single tokens, so spaces and quotes keep the key unambiguous
+            for (size_t i = firstTerm; i < terms.size(); ++i) {
+                if (!parsed.key.empty()) parsed.key += ' ';
+                if (phrase && i == firstTerm) parsed.key += '"';
+                parsed.key += terms[i].term;
+            }
+            if (phrase) {
+                parsed.key += '"';
+                if (!phrases.back().ordered) parsed.key += '~' + std::to_string(phrases.back().slop);
+            }
         }
+        parsed.key += " |";
+        parsed.key += ranking::name(parsed.ranking);
+        parsed.queryHash = flat::hash(parsed.key);
+        return parsed;
+    }
+
+    // Quoted parts of the query are phrases ("dark matter") or proximity
+    // groups ("dark matter"~3); they need an index built with positions and
+    // otherwise count as plain terms. Returns the results serialized as a
+    // JSON array.
+    std::string search(const std::string& query) { return search(parseQuery(query)); }
+
+    // `next`, if given, receives the cursor of the following page, or is
+    // cleared if this page is the last.
+    std::string search(ParsedQuery parsed, std::string* next = nullptr) {
+        return render(rank(std::move(parsed), next));
+    }
 
+    // Sets the page a parsed query returns: k results (1..MAX_PAGE) after
+    // skipping `offset` (up to MAX_OFFSET) of them, counted from the start
+    // or, with a cursor from a previous page of the same query, from where
+    // that page ended. False if any of them is out of range or the cursor is
+    // malformed or belongs to another query.
+    bool paginate(ParsedQuery& parsed, size_t k, size_t offset, const std::string& cursor = "") const {
+        if (k == 0 || k > MAX_PAGE || offset > MAX_OFFSET) return false;
+        parsed.k = k;
+        parsed.offset = offset;
+        parsed.resume = !cursor.empty();
+        if (parsed.resume && !decodeCursor(cursor, parsed.queryHash, parsed.after)) return false;
+        if (k != TOP_K || offset != 0) parsed.key += " |" + std::to_string(k) + "+" + std::to_string(offset);
+        if (parsed.resume) parsed.key += " |@" + cursor;
+        return true;
+    }
+
+    // One page of the query's results, best first (see paginate).
+    //
+    // A page is the best offset + k results that rank after the cursor, kept
+    // in a bounded heap while the postings are evaluated; no candidate set
+    // is materialized and sorted, and with block-max evaluation blocks that
+    // cannot place are still skipped. The cursor records which evaluation
+    // (stage 0, or the stage-1 fallback taken when stage 0 had no hits)
+    // ranked the first page, so later pages continue the same ranking even
+    // where stage 0 has run out.
+    std::vector<SearchResult> rank(ParsedQuery parsed, std::string* next = nullptr) {
+        if (next) next->clear();
+        std::vector<TermInfo>& terms = parsed.terms;
+        const std::vector<Phrase>& phrases = parsed.phrases;
+        bool decoded = exhaustive;
+        bool phrasesOn = loadTerms(terms, phrases, decoded);
         if (terms.empty()) return {};
+        Scorer sc = scorerFor(parsed.ranking);
+        size_t k = parsed.offset + parsed.k;
+        const PageCursor* after = parsed.resume ? &parsed.after : nullptr;
+        uint8_t stage = after ? after->stage : 0;
 
-        for (size_t i = 0; i < terms.size(); ++i) {
-            terms[i].list = futures[i].get();
-            terms[i].docCount = terms[i].list.docs.size();
+        // Cursor for the page after this one, then the page itself; impact
+        // sums are reported on the BM25 scale
+        auto ranked = [&](std::vector<SearchResult>& results) {
+            if (next && results.size() == k)
+                *next = encodeCursor({ results.back().score, results.back().docId, stage }, parsed.queryHash);
+            results.erase(results.begin(), results.begin() + std::min(parsed.offset, results.size()));
+            if (sc.mode == Ranking::Impact)
+                for (auto& r : results) r.score *= sc.scale;
+            return results;
+        };
+
+        // Relaxation [cite: 60, 61]: terms are dropped longest list first until
+        // the AND has hits, all in one quorum pass. With phrases, only free
+        // terms are dropped while the phrases must still match; if they never
+        // do, every term comes back and is relaxed as a plain word.
+        // Without decoded lists, the full AND usually has hits and the
+        // block-max evaluator finds them; a miss falls back to the quorum pass.
+        std::vector<SearchResult> results;
+        if (!decoded) {
+            if (stage == 0) results = blockMaxTopK(terms, k, sc, after);
+            if (after ? stage == 1 : results.empty() && terms.size() > 1) {
+                stage = 1;
+                results = quorumCursorTopK(terms, k, sc, after);
+            }
+            return ranked(results);
         }
+        if (stage == 0) results = quorumTopK(terms, phrasesOn ? phrases : std::vector<Phrase>{}, k, sc, after);
+        if (after ? stage == 1 : results.empty() && phrasesOn) {
+            stage = 1;
+            results = quorumTopK(terms, {}, k, sc, after);
+        }
+        return ranked(results);
+    }
 
-        std::sort(terms.begin(), terms.end(), [](auto& a, auto& b) { return a.docCount < b.docCount; });
+    // ===================== DENSE AND HYBRID SEARCH =====================
+
+    // Dense search for /semantic. q is either a query vector (the documents'
+    // dimension count of numbers, separated by commas or spaces) or the
+    // original ID of a stored document, whose neighbours are returned
+    // without it. Results are scored by cosine similarity. With `text`, the
+    // dense ranking is fused with search(text)'s by reciprocal rank fusion,
+    // and the fused score is reported instead.
+    std::string semanticSearch(const std::string& q, const std::string& text = "", size_t k = TOP_K) {
+        if (!docVectors.isOpen() || k == 0) return "[]";
+        std::vector<float> query;
+        uint32_t self = UINT32_MAX;
+        if (!parseVector(q, query)) {
+            const float* v = findDoc(q, self) ? docVectors.vector(self) : nullptr;
+            if (!v) return "[]";
+            query.assign(v, v + docVectors.dimensions());
+        }
+
+        size_t depth = text.empty() ? k : std::max(k, FUSION_DEPTH);
+        std::vector<SearchResult> dense;
+        for (const auto& [sim, doc] : docVectors.nearest(query.data(), depth + (self != UINT32_MAX)))
+            if (doc != self && docTable.has(doc)) dense.push_back({ doc, sim });
+        if (dense.size() > depth) dense.resize(depth);
+        if (text.empty()) return render(dense);
+
+        std::unordered_map<uint32_t, double> fused;
+        auto add = [&](const std::vector<SearchResult>& list) {
+            for (size_t r = 0; r < list.size(); ++r) fused[list[r].docId] += 1.0 / (RRF_K + double(r + 1));
+        };
+        add(dense);
+        ParsedQuery lexical = parseQuery(text);
+        lexical.k = depth;
+        add(rank(std::move(lexical)));
+        std::vector<SearchResult> results;
+        results.reserve(fused.size());
+        for (const auto& [doc, score] : fused) results.push_back({ doc, score });
+        return render(topK(results, k));
+    }
+
+private:
+    // Numbers of a query vector into v, normalized; false unless there are
+    // exactly as many as the document vectors have
+    bool parseVector(const std::string& s, std::vector<float>& v) const {
+        v.clear();
+        const char* p = s.c_str();
+        while (*p) {
+            if (*p == ',' || std::isspace(static_cast<unsigned char>(*p))) { ++p; continue; }
+            char* end;
+            float x = std::strtof(p, &end);
+            if (end == p) return false;
+            v.push_back(x);
+            p = end;
+        }
+        return v.size() == docVectors.dimensions() && vecmath::normalize(v.data(), v.size());
+    }
+
+    // A cursor travels as hex: u8 version | u8 stage | f64 score | u32 doc |
+    // u32 low bits of the query hash
+    static std::string encodeCursor(const PageCursor& c, uint64_t queryHash) {
+        uint8_t raw[18];
+        uint32_t check = static_cast<uint32_t>(queryHash);
+        raw[0] = 1;
+        raw[1] = c.stage;
+        std::memcpy(raw + 2, &c.score, sizeof(c.score));
+        std::memcpy(raw + 10, &c.docId, sizeof(c.docId));
+        std::memcpy(raw + 14, &check, sizeof(check));
+        static const char* digits = "0123456789abcdef";
+        std::string out;
+        for (uint8_t b : raw) {
+            out += digits[b >> 4];
+            out += digits[b & 15];
+        }
+        return out;
+    }
+
+    static bool decodeCursor(const std::string& s, uint64_t queryHash, PageCursor& c) {
+        uint8_t raw[18];
+        if (s.size() != 2 * sizeof(raw)) return false;
+        auto nibble = [](char h) {
+            return h >= '0' && h <= '9' ? h - '0' : h >= 'a' && h <= 'f' ? h - 'a' + 10 : -1;
+        };
+        for (size_t i = 0; i < sizeof(raw); ++i) {
+            int hi = nibble(s[2 * i]), lo = nibble(s[2 * i + 1]);
+            if (hi < 0 || lo < 0) return false;
+            raw[i] = static_cast<uint8_t>(hi << 4 | lo);
+        }
+        uint32_t check;
+        std::memcpy(&c.score, raw + 2, sizeof(c.score));
+        std::memcpy(&c.docId, raw + 10, sizeof(c.docId));
+        std::memcpy(&check, raw + 14, sizeof(check));
+        c.stage = raw[1];
+        return raw[0] == 1 && c.stage <= 1 && check == static_cast<uint32_t>(queryHash) && std::isfinite(c.score);
+    }
 
-        while (!terms.empty()) {
-            auto results = runStrictAND(terms);
-            if (!results.empty()) return results;
-            terms.pop_back(); // Relaxation Loop [cite: 60, 61]
+    // Internal ID of a document by its original ID
+    bool findDoc(std::string_view externalId, uint32_t& doc) const {
+        return docIndex.find(externalId, doc) && docTable.has(doc);
+    }
+
+public:
+
+    // Times the full AND of every query (first relaxation step, postings
+    // already fetched) with the sorted-array kernels and with the old hash-map
+    // version, checks both give the same scores, and prints per-query and
+    // total timings. Both score with the default ranking. Returns false on
+    // any mismatch.
+    bool benchmarkIntersection(const std::vector<std::string>& queries, int rounds = 20) {
+        Scorer sc = scorerFor(defaultRanking);
+        using Clock = std::chrono::steady_clock;
+        auto byDoc = [](std::vector<SearchResult> v) {
+            std::sort(v.begin(), v.end(), [](auto& a, auto& b) { return a.docId < b.docId; });
+            return v;
+        };
+        double hashTotal = 0, sortedTotal = 0;
+        bool allMatch = true;
+        for (const auto& q : queries) {
+            std::vector<TermInfo> terms;
+            std::vector<Phrase> phrases;
+            bool decode = true;
+            prepareTerms(q, terms, phrases, decode);
+            if (terms.empty()) continue;
+            size_t postings = 0;
+            for (const auto& t : terms) postings += std::min(t.list.docs.size(), MAX_DOCS_PER_TERM);
+
+            std::vector<SearchResult> hashed, sorted;
+            auto t0 = Clock::now();
+            for (int r = 0; r < rounds; ++r) hashed = hashIntersectTerms(terms, sc);
+            auto t1 = Clock::now();
+            for (int r = 0; r < rounds; ++r) sorted = intersectTerms(terms, sc);
+            auto t2 = Clock::now();
+
+            double hashUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / rounds;
+            double sortedUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / rounds;
+            hashed = byDoc(std::move(hashed));
+            bool match = hashed.size() == sorted.size() &&
+                         std::equal(hashed.begin(), hashed.end(), sorted.begin(), [](auto& a, auto& b) {
+                             return a.docId == b.docId && a.score == b.score;
+                         });
+            allMatch = allMatch && match;
+            hashTotal += hashUs;
+            sortedTotal += sortedUs;
+            std::cout << "[Bench] \"" << q << "\" terms=" << terms.size() << " postings=" << postings
+                      << " hits=" << sorted.size() << " hash=" << hashUs << " us sorted=" << sortedUs
+                      << " us x" << (sortedUs > 0 ? hashUs / sortedUs : 0.0)
+                      << (match ? "" : "  MISMATCH") << "\n";
+        }
+        std::cout << "[Bench] Total hash=" << hashTotal << " us sorted=" << sortedTotal << " us x"
+                  << (sortedTotal > 0 ? hashTotal / sortedTotal : 0.0) << "\n";
+        return allMatch;
+    }
+
+    // Times the top-k of every query's full AND exhaustively and with the
+    // block-max evaluator, checks the rankings are identical and prints the
+    // postings scored and blocks decoded by each. Both score with the default
+    // ranking. Returns false on any mismatch.
+    bool benchmarkTopK(const std::vector<std::string>& queries, int rounds = 20) {
+        Scorer sc = scorerFor(defaultRanking);
+        using Clock = std::chrono::steady_clock;
+        double fullTotal = 0, pruneTotal = 0;
+        size_t fullScored = 0, pruneScored = 0;
+        bool allMatch = true;
+        for (const auto& q : queries) {
+            std::vector<TermInfo> terms;
+            std::vector<Phrase> phrases;
+            bool decode = true;
+            prepareTerms(q, terms, phrases, decode);
+            if (terms.empty()) continue;
+
+            // Exhaustive timing includes decoding, as a query would pay it
+            std::vector<SearchResult> full, pruned;
+            size_t scored = 0, pScored = 0, blocks = 0, totalBlocks = 0;
+            auto t0 = Clock::now();
+            for (int r = 0; r < rounds; ++r) {
+                scored = 0;
+                std::vector<TermInfo> fresh(terms.size());
+                for (size_t i = 0; i < terms.size(); ++i) fresh[i].list = fetchPostingList(terms[i].wordID);
+                auto all = intersectTerms(fresh, sc, &scored);
+                full = topK(all, TOP_K);
+            }
+            auto t1 = Clock::now();
+            for (int r = 0; r < rounds; ++r) {
+                pScored = blocks = 0;
+                pruned = blockMaxTopK(terms, TOP_K, sc, nullptr, &pScored, &blocks);
+            }
+            auto t2 = Clock::now();
+            for (const auto& t : terms)
+                totalBlocks += (std::min(t.list.docs.size(), MAX_DOCS_PER_TERM) + PostingCodec::BLOCK_SIZE - 1) /
+                               PostingCodec::BLOCK_SIZE;
+
+            double fullUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / rounds;
+            double pruneUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / rounds;
+            bool match = full.size() == pruned.size() &&
+                         std::equal(full.begin(), full.end(), pruned.begin(), [](auto& a, auto& b) {
+                             return a.docId == b.docId && a.score == b.score;
+                         });
+            allMatch = allMatch && match;
+            fullTotal += fullUs;
+            pruneTotal += pruneUs;
+            fullScored += scored;
+            pruneScored += pScored;
+            std::cout << "[Bench] \"" << q << "\" scored " << scored << " -> " << pScored
+                      << ", blocks " << totalBlocks << " -> " << blocks
+                      << ", exhaustive=" << fullUs << " us block-max=" << pruneUs << " us"
+                      << (match ? "" : "  MISMATCH") << "\n";
+        }
+        std::cout << "[Bench] Total scored " << fullScored << " -> " << pruneScored
+                  << ", exhaustive=" << fullTotal << " us block-max=" << pruneTotal << " us\n";
+        return allMatch;
+    }
+
+    // Walks `pages` pages of ten results of every query twice, by cursor and
+    // by offset, and checks both equal one ranking of pages x 10 results.
+    // Prints per-query timings; false on any mismatch.
+    bool benchmarkPagination(const std::vector<std::string>& queries, size_t pages = 10) {
+        using Clock = std::chrono::steady_clock;
+        pages = std::clamp<size_t>(pages, 1, MAX_OFFSET / TOP_K + 1);
+        auto same = [](const std::vector<SearchResult>& a, const std::vector<SearchResult>& b) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](auto& x, auto& y) {
+                return x.docId == y.docId && x.score == y.score;
+            });
+        };
+        double cursorTotal = 0, offsetTotal = 0;
+        bool allMatch = true;
+        for (const auto& q : queries) {
+            ParsedQuery whole = parseQuery(q);
+            whole.k = pages * TOP_K;
+            std::vector<SearchResult> expected = rank(std::move(whole));
+            if (expected.empty()) continue;
+
+            std::vector<SearchResult> byCursor, byOffset;
+            std::string cursor;
+            auto t0 = Clock::now();
+            for (size_t p = 0; p < pages; ++p) {
+                ParsedQuery page = parseQuery(q);
+                if (!paginate(page, TOP_K, 0, cursor)) break;
+                auto part = rank(std::move(page), &cursor);
+                byCursor.insert(byCursor.end(), part.begin(), part.end());
+                if (cursor.empty()) break;
+            }
+            auto t1 = Clock::now();
+            for (size_t p = 0; p < pages; ++p) {
+                ParsedQuery page = parseQuery(q);
+                paginate(page, TOP_K, p * TOP_K);
+                auto part = rank(std::move(page));
+                byOffset.insert(byOffset.end(), part.begin(), part.end());
+                if (part.size() < TOP_K) break;
+            }
+            auto t2 = Clock::now();
+
+            double cursorUs = std::chrono::duration<double, std::micro>(t1 - t0).count();
+            double offsetUs = std::chrono::duration<double, std::micro>(t2 - t1).count();
+            bool match = same(byCursor, expected) && same(byOffset, expected);
+            allMatch = allMatch && match;
+            cursorTotal += cursorUs;
+            offsetTotal += offsetUs;
+            std::cout << "[Bench] \"" << q << "\" " << expected.size() << " results, cursor=" << cursorUs
+                      << " us offset=" << offsetUs << " us" << (match ? "" : "  MISMATCH") << "\n";
+        }
+        std::cout << "[Bench] Total cursor=" << cursorTotal << " us offset=" << offsetTotal << " us\n";
+        return allMatch;
+    }
+
+    // Semantic neighbours of each word from the graph against a scan of all
+    // lexicon vectors; words without a vector are skipped. True if the graph
+    // found the exact neighbour for at least 90% of the words.
+    bool benchmarkSemantic(const std::vector<std::string>& words, int rounds = 20) {
+        if (semanticIndex.empty()) {
+            std::cerr << "[Bench][ERROR] No semantic index, load word vectors first\n";
+            return false;
+        }
+        using Clock = std::chrono::steady_clock;
+        size_t dim = wordVectors.dimensions(), tested = 0, agree = 0;
+        double scanTotal = 0, graphTotal = 0;
+        for (const auto& w : words) {
+            uint32_t row;
+            if (!wordVectors.find(w, row)) continue;
+            const float* q = wordVectors.row(row);
+
+            uint32_t exact = UINT32_MAX;
+            auto t0 = Clock::now();
+            for (int r = 0; r < rounds; ++r) {
+                float best = -2.0f;
+                for (uint32_t n = 0; n < semanticRows.size(); ++n) {
+                    if (semanticRows[n] == row) continue;
+                    float s = vecmath::dot(q, wordVectors.row(semanticRows[n]), dim);
+                    if (s > best) { best = s; exact = n; }
+                }
+            }
+            auto t1 = Clock::now();
+            if (exact == UINT32_MAX) continue; // the word is the graph's only node
+            uint32_t approx = UINT32_MAX;
+            for (int r = 0; r < rounds; ++r)
+                for (const auto& [s, n] : semanticIndex.search(q, 2))
+                    if (semanticRows[n] != row) { approx = n; break; }
+            auto t2 = Clock::now();
+
+            double scanUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / rounds;
+            double graphUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / rounds;
+            ++tested;
+            agree += approx == exact;
+            scanTotal += scanUs;
+            graphTotal += graphUs;
+            std::cout << "[Bench] \"" << w << "\" -> \"" << wordVectors.word(semanticRows[exact]) << "\""
+                      << ", scan=" << scanUs << " us graph=" << graphUs << " us"
+                      << (approx == exact ? "" : "  MISS") << "\n";
+        }
+        if (tested == 0) {
+            std::cerr << "[Bench][ERROR] None of the words has a vector\n";
+            return false;
         }
-        return {};
+        std::cout << "[Bench] " << agree << "/" << tested << " exact, mean scan=" << scanTotal / tested
+                  << " us graph=" << graphTotal / tested << " us\n";
+        return agree * 10 >= tested * 9;
     }
 };
 
@@ -0,0 +1,139 @@
+#ifndef SPELL_INDEX_HPP
+#define SPELL_INDEX_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "FlatTables.hpp"
+
+// Symmetric-delete (SymSpell) index over the lexicon for one-edit spelling
+// correction. Every word is filed under itself and under each string left by
+// deleting one of its characters; a misspelled term looks up the same
+// variants of itself. Two strings one insertion, deletion or substitution
+// apart always share a variant, so this finds every lexicon word one edit
+// away, plus some that are not, which verification drops.
+//
+// Variants are not stored, only their hashes: a CSR table from hash bucket to
+// the lexicon indices filed there. Colliding variants only add candidates.
+// Edits count bytes, as the old edit distance did.
+//
+// The table is one flat buffer, so it can be saved in the engine snapshot
+// and viewed there instead of rebuilt (u32 fields):
+//   bucketCount | wordCount | (bucketCount + 1) x bucketStart | wordCount x word
+// Bucket b holds words[bucketStart[b] .. bucketStart[b + 1]), the lexicon
+// entry indices filed under it.
+
+class SpellIndex {
+private:
+    std::vector<uint8_t> owned;
+    const uint8_t* base = nullptr;
+    size_t bytes = 0;
+    const uint8_t* bucketStart = nullptr;
+    const uint8_t* words = nullptr;
+    uint32_t wordCount = 0;
+    uint64_t mask = 0;
+
+    uint32_t start(uint64_t bucket) const { return flat::readU32(bucketStart + bucket * 4); }
+
+    // Hash of w without the byte at skip (skip == w.size(): w itself)
+    static uint64_t variantHash(std::string_view w, size_t skip) {
+        uint64_t h = 1469598103934665603ull;
+        for (size_t i = 0; i < w.size(); ++i) {
+            if (i == skip) continue;
+            h ^= static_cast<unsigned char>(w[i]);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Calls f(hash) for w and each distinct one-byte deletion of it; deleting
+    // any byte of a run gives the same string, so only the first counts
+    template <typename F>
+    static void forEachVariant(std::string_view w, F&& f) {
+        f(variantHash(w, w.size()));
+        for (size_t i = 0; i < w.size(); ++i)
+            if (i == 0 || w[i] != w[i - 1]) f(variantHash(w, i));
+    }
+
+public:
+    // True if a and b are at most one insertion, deletion or substitution apart
+    static bool withinOneEdit(std::string_view a, std::string_view b) {
+        if (a.size() > b.size()) std::swap(a, b);
+        if (b.size() - a.size() > 1) return false;
+        size_t i = 0;
+        while (i < a.size() && a[i] == b[i]) ++i;
+        if (i == a.size()) return true;
+        return a.size() == b.size() ? a.substr(i + 1) == b.substr(i + 1) : a.substr(i) == b.substr(i + 1);
+    }
+
+    SpellIndex() = default;
+    SpellIndex(const SpellIndex&) = delete;
+    SpellIndex& operator=(const SpellIndex&) = delete;
+    SpellIndex(SpellIndex&&) = default;            // the heap buffer, and so every
+    SpellIndex& operator=(SpellIndex&&) = default; // pointer into it, survives a move
+
+    void build(const StringTable& lexicon) {
+        size_t variants = 0;
+        for (size_t i = 0; i < lexicon.size(); ++i)
+            forEachVariant(lexicon.key(i), [&](uint64_t) { ++variants; });
+
+        size_t buckets = 1;
+        while (buckets * 2 < variants) buckets <<= 1; // about two words per bucket
+        uint64_t m = buckets - 1;
+
+        std::vector<uint32_t> starts(buckets + 1, 0);
+        for (size_t i = 0; i < lexicon.size(); ++i)
+            forEachVariant(lexicon.key(i), [&](uint64_t h) { ++starts[(h & m) + 1]; });
+        for (size_t b = 0; b < buckets; ++b) starts[b + 1] += starts[b];
+
+        std::vector<uint32_t> filed(variants, 0);
+        std::vector<uint32_t> fill(starts.begin(), starts.end() - 1);
+        for (size_t i = 0; i < lexicon.size(); ++i)
+            forEachVariant(lexicon.key(i), [&](uint64_t h) { filed[fill[h & m]++] = static_cast<uint32_t>(i); });
+
+        std::vector<uint8_t> out;
+        out.reserve((2 + starts.size() + filed.size()) * sizeof(uint32_t));
+        flat::putU32(out, static_cast<uint32_t>(buckets));
+        flat::putU32(out, static_cast<uint32_t>(variants));
+        for (uint32_t v : starts) flat::putU32(out, v);
+        for (uint32_t v : filed) flat::putU32(out, v);
+        owned = std::move(out);
+        attach(owned.data(), owned.size());
+    }
+
+    // Views an existing buffer (e.g. a snapshot section) built for the same
+    // lexicon; it must outlive the index
+    bool attach(const uint8_t* p, size_t size) {
+        base = nullptr; bytes = 0; wordCount = 0; mask = 0;
+        if (size < 8) return false;
+        uint32_t buckets = flat::readU32(p), n = flat::readU32(p + 4);
+        if (buckets == 0 || (buckets & (buckets - 1)) != 0 ||
+            size != (2 + uint64_t(buckets) + 1 + n) * sizeof(uint32_t) ||
+            flat::readU32(p + 8 + uint64_t(buckets) * 4) != n)
+            return false;
+        base = p; bytes = size; wordCount = n; mask = buckets - 1;
+        bucketStart = p + 8;
+        words = bucketStart + (uint64_t(buckets) + 1) * 4;
+        return true;
+    }
+
+    bool empty() const { return wordCount == 0; }
+    const uint8_t* data() const { return base; }
+    size_t byteSize() const { return bytes; }
+
+    // Calls onWord(index) for every entry of `lexicon` (the table the index
+    // was built from) within one edit of term; an index may repeat
+    template <typename F>
+    void candidates(std::string_view term, const StringTable& lexicon, F&& onWord) const {
+        if (wordCount == 0) return;
+        forEachVariant(term, [&](uint64_t h) {
+            for (uint32_t k = start(h & mask), end = start((h & mask) + 1); k < end; ++k) {
+                uint32_t w = flat::readU32(words + uint64_t(k) * 4);
+                if (withinOneEdit(term, lexicon.key(w))) onWord(w);
+            }
+        });
+    }
+};
+
+#endif
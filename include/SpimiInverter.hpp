@@ -0,0 +1,230 @@
+#ifndef SPIMI_INVERTER_HPP
+#define SPIMI_INVERTER_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <queue>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
+#include "PostingCodec.hpp"
+
+// Memory-budgeted inversion (SPIMI). Postings are added in doc order and
+// collected per term in memory; when the estimated footprint reaches the
+// budget the buffer is sorted by word ID and spilled to a run file. finish()
+// streams a k-way merge over all runs and hands each term's complete posting
+// list to a callback, in word ID order.
+//
+// Runs are written in doc order, so for any term the postings of run i all
+// precede those of run i+1: merging a term is a concatenation in run order.
+//
+// A run that cannot be written or read back fails the inverter: add() then
+// drops its input, so memory stays bounded, and finish() returns false.
+//
+// Run file: repeated { u32 wordID, u32 count, count x Posting,
+//                     u32 positionCount, positionCount x u32 position }.
+
+class SpimiInverter {
+private:
+    // Rough per-entry costs used for the budget estimate
+    static constexpr size_t TERM_OVERHEAD = 64;
+
+    size_t memoryBudget;
+    std::string runDir;
+
+    std::unordered_map<uint32_t, PostingList> buffer;
+    size_t bufferedBytes = 0;
+    std::vector<std::string> runs;
+    bool failed = false;
+
+    struct RunReader {
+        std::ifstream in;
+        uint32_t wordID = 0;
+        PostingList list;
+        bool done = false;
+        bool failed = false; // missing, truncated or unreadable run
+
+        explicit RunReader(const std::string& path) : in(path, std::ios::binary) { next(); }
+
+        bool readAll(void* dst, size_t bytes) {
+            in.read(static_cast<char*>(dst), bytes);
+            return in && static_cast<size_t>(in.gcount()) == bytes;
+        }
+
+        void next() {
+            uint32_t count = 0, positionCount = 0;
+            if (!readAll(&wordID, sizeof(wordID))) {
+                // A run ends cleanly only between records
+                failed = !in.eof() || in.gcount() != 0;
+                done = true;
+                return;
+            }
+            bool ok = readAll(&count, sizeof(count));
+            if (ok) {
+                list.postings.resize(count);
+                ok = readAll(list.postings.data(), count * sizeof(Posting)) &&
+                     readAll(&positionCount, sizeof(positionCount));
+            }
+            if (ok) {
+                list.positions.resize(positionCount);
+                ok = readAll(list.positions.data(), positionCount * sizeof(uint32_t));
+            }
+            if (!ok) failed = done = true;
+        }
+    };
+
+    // Drops the buffer and marks the inverter failed
+    bool fail() {
+        failed = true;
+        std::unordered_map<uint32_t, PostingList>().swap(buffer);
+        bufferedBytes = 0;
+        return false;
+    }
+
+    void removeRuns() {
+        for (const auto& r : runs) std::filesystem::remove(r);
+        runs.clear();
+        std::error_code ec;
+        std::filesystem::remove(runDir, ec); // only succeeds if empty
+    }
+
+    bool spill() {
+        if (failed) return false;
+        if (buffer.empty()) return true;
+
+        std::vector<uint32_t> ids;
+        ids.reserve(buffer.size());
+        for (auto& kv : buffer) ids.push_back(kv.first);
+        std::sort(ids.begin(), ids.end());
+
+        std::error_code ec;
+        std::filesystem::create_directories(runDir, ec); // a failure shows when the run is opened
+        std::string path = runDir + "/run_" + std::to_string(runs.size()) + ".bin";
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << "[SPIMI][ERROR] Cannot write run file: " << path << "\n";
+            return fail();
+        }
+        for (uint32_t wid : ids) {
+            const auto& list = buffer[wid];
+            uint32_t count = static_cast<uint32_t>(list.postings.size());
+            uint32_t positionCount = static_cast<uint32_t>(list.positions.size());
+            out.write(reinterpret_cast<const char*>(&wid), sizeof(wid));
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            out.write(reinterpret_cast<const char*>(list.postings.data()), count * sizeof(Posting));
+            out.write(reinterpret_cast<const char*>(&positionCount), sizeof(positionCount));
+            out.write(reinterpret_cast<const char*>(list.positions.data()), positionCount * sizeof(uint32_t));
+        }
+        out.close();
+        if (!out) {
+            std::cerr << "[SPIMI][ERROR] Failed writing run file: " << path << "\n";
+            std::filesystem::remove(path, ec);
+            return fail();
+        }
+        runs.push_back(path);
+
+        std::cout << "\n[SPIMI] Spilled run " << runs.size() << " (" << ids.size() << " terms, "
+                  << bufferedBytes / (1024 * 1024) << " MB)\n";
+        std::unordered_map<uint32_t, PostingList>().swap(buffer);
+        bufferedBytes = 0;
+        return true;
+    }
+
+public:
+    SpimiInverter(size_t budgetBytes, const std::string& tmpDir)
+        : memoryBudget(budgetBytes), runDir(tmpDir) {}
+
+    // Postings must arrive in non-decreasing doc order. `positions`, if given,
+    // points at the posting's p.tf word positions. Ignored once a run has
+    // failed.
+    void add(uint32_t wordID, const Posting& p, const uint32_t* positions = nullptr) {
+        if (failed) return;
+        auto [it, inserted] = buffer.try_emplace(wordID);
+        if (inserted) bufferedBytes += TERM_OVERHEAD;
+        auto& list = it->second;
+        if (list.postings.size() == list.postings.capacity())
+            bufferedBytes += std::max<size_t>(list.postings.capacity(), 1) * sizeof(Posting);
+        list.postings.push_back(p);
+        if (positions) {
+            if (list.positions.capacity() - list.positions.size() < p.tf)
+                bufferedBytes += std::max<size_t>(list.positions.capacity(), p.tf) * sizeof(uint32_t);
+            list.positions.insert(list.positions.end(), positions, positions + p.tf);
+        }
+        if (bufferedBytes >= memoryBudget) spill();
+    }
+
+    size_t runCount() const { return runs.size(); }
+    bool good() const { return !failed; }
+
+    // Streams every term's merged postings to onTerm(wordID, PostingList), in
+    // ascending word ID order, then deletes the run files. False if a run
+    // could not be written or read back; the terms emitted before that are
+    // then incomplete.
+    template <typename F>
+    bool finish(F&& onTerm) {
+        if (failed) {
+            removeRuns();
+            return false;
+        }
+        PostingList merged;
+
+        // Everything fit in memory: no runs, emit the buffer directly
+        if (runs.empty()) {
+            std::vector<uint32_t> ids;
+            ids.reserve(buffer.size());
+            for (auto& kv : buffer) ids.push_back(kv.first);
+            std::sort(ids.begin(), ids.end());
+            for (uint32_t wid : ids) {
+                merged = std::move(buffer[wid]);
+                onTerm(wid, merged);
+                merged = PostingList();
+            }
+            buffer.clear();
+            bufferedBytes = 0;
+            return true;
+        }
+
+        if (!spill()) {
+            removeRuns();
+            return false;
+        }
+
+        std::vector<std::unique_ptr<RunReader>> readers;
+        for (const auto& r : runs) readers.push_back(std::make_unique<RunReader>(r));
+
+        // Min-heap on (wordID, run index)
+        using Key = std::pair<uint32_t, size_t>;
+        std::priority_queue<Key, std::vector<Key>, std::greater<>> heap;
+        for (size_t i = 0; i < readers.size(); ++i) {
+            if (readers[i]->failed) failed = true;
+            else if (!readers[i]->done) heap.push({ readers[i]->wordID, i });
+        }
+
+        while (!failed && !heap.empty()) {
+            uint32_t wid = heap.top().first;
+            merged.postings.clear();
+            merged.positions.clear();
+            while (!heap.empty() && heap.top().first == wid) {
+                size_t r = heap.top().second;
+                heap.pop();
+                auto& reader = *readers[r];
+                merged.postings.insert(merged.postings.end(), reader.list.postings.begin(), reader.list.postings.end());
+                merged.positions.insert(merged.positions.end(), reader.list.positions.begin(), reader.list.positions.end());
+                reader.next();
+                if (reader.failed) failed = true;
+                else if (!reader.done) heap.push({ reader.wordID, r });
+            }
+            if (!failed) onTerm(wid, merged);
+        }
+        if (failed) std::cerr << "[SPIMI][ERROR] Truncated or unreadable run file in " << runDir << "\n";
+
+        readers.clear();
+        removeRuns();
+        return !failed;
+    }
+};
+
+#endif
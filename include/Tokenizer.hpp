@@ -0,0 +1,236 @@
+#ifndef TOKENIZER_HPP
+#define TOKENIZER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TOKENIZER_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// The one text normalizer shared by every indexer and by query parsing, so
+// index-time and query-time terms cannot drift apart.
+//
+// A token is a maximal run of word characters: ASCII letters and digits, and
+// UTF-8 encoded letters (Latin, Greek, Cyrillic and other scripts; not
+// punctuation, symbols or emoji). Letters are lowercased; digits and
+// combining marks stay inside the token but are dropped from it, so "H2O"
+// becomes "ho". Empty results and stop words are skipped.
+//
+// Classification is a 256-entry byte table. Runs of lowercase ASCII, which
+// make up most of the text, are copied 16 bytes at a time.
+
+namespace tokenizer {
+
+enum ByteClass : uint8_t { SEP, DIGIT, UPPER, LOWER, LEAD2, LEAD3, LEAD4 };
+
+constexpr std::array<uint8_t, 256> makeByteClasses() {
+    std::array<uint8_t, 256> t{};
+    for (int c = '0'; c <= '9'; ++c) t[c] = DIGIT;
+    for (int c = 'A'; c <= 'Z'; ++c) t[c] = UPPER;
+    for (int c = 'a'; c <= 'z'; ++c) t[c] = LOWER;
+    for (int c = 0xC2; c <= 0xDF; ++c) t[c] = LEAD2;
+    for (int c = 0xE0; c <= 0xEF; ++c) t[c] = LEAD3;
+    for (int c = 0xF0; c <= 0xF4; ++c) t[c] = LEAD4;
+    return t;
+}
+
+inline constexpr std::array<uint8_t, 256> BYTE_CLASS = makeByteClasses();
+
+// Index stop words; all are at most 4 bytes long
+inline constexpr std::string_view STOP_WORDS[] = {
+    "the", "and", "is", "in", "at", "of", "on", "for", "to", "a", "an", "that", "it"
+};
+
+inline bool isStopWord(std::string_view w) {
+    if (w.size() > 4) return false;
+    for (auto s : STOP_WORDS)
+        if (s == w) return true;
+    return false;
+}
+
+// Length of the run of 'a'..'z' starting at p
+inline size_t lowerRun(const char* p, const char* end) {
+    const char* start = p;
+#ifdef TOKENIZER_SSE2
+    // c - 'a' < 26 (unsigned), as a signed compare after biasing by 0x80
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80 - 'a'));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(-128 + 26));
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), bias);
+        unsigned m = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmplt_epi8(v, limit)));
+        if (m != 0xFFFF) {
+#ifdef _MSC_VER
+            unsigned long i;
+            _BitScanForward(&i, ~m);
+            return static_cast<size_t>(p - start) + i;
+#else
+            return static_cast<size_t>(p - start) + __builtin_ctz(~m);
+#endif
+        }
+    }
+#endif
+    while (p < end && BYTE_CLASS[static_cast<uint8_t>(*p)] == LOWER) ++p;
+    return static_cast<size_t>(p - start);
+}
+
+// Decodes one UTF-8 sequence at p; returns its length, or 0 if invalid
+inline size_t decodeUtf8(const char* p, const char* end, uint32_t& cp) {
+    auto cont = [](char c) { return (static_cast<uint8_t>(c) & 0xC0) == 0x80; };
+    uint8_t b = static_cast<uint8_t>(*p);
+    uint8_t cls = BYTE_CLASS[b];
+    size_t n = cls == LEAD2 ? 2 : cls == LEAD3 ? 3 : cls == LEAD4 ? 4 : 0;
+    if (n == 0 || end - p < static_cast<std::ptrdiff_t>(n)) return 0;
+    for (size_t i = 1; i < n; ++i)
+        if (!cont(p[i])) return 0;
+    if (n == 2) cp = (b & 0x1Fu) << 6 | (p[1] & 0x3Fu);
+    else if (n == 3) cp = (b & 0x0Fu) << 12 | (p[1] & 0x3Fu) << 6 | (p[2] & 0x3Fu);
+    else cp = (b & 0x07u) << 18 | (p[1] & 0x3Fu) << 12 | (p[2] & 0x3Fu) << 6 | (p[3] & 0x3Fu);
+    // Reject overlong forms, surrogates and values past U+10FFFF
+    if ((n == 3 && cp < 0x800) || (n == 4 && (cp < 0x10000 || cp > 0x10FFFF)) ||
+        (cp >= 0xD800 && cp <= 0xDFFF))
+        return 0;
+    return n;
+}
+
+enum CodePointClass { CP_SEP, CP_MARK, CP_LETTER };
+
+inline CodePointClass classify(uint32_t cp) {
+    if (cp < 0xC0 || cp == 0xD7 || cp == 0xF7) return CP_SEP;       // Latin-1 punctuation, x, /
+    if (cp >= 0x0300 && cp <= 0x036F) return CP_MARK;               // combining diacritics
+    if (cp >= 0x2000 && cp <= 0x2BFF) return CP_SEP;                // punctuation, symbols, arrows, math
+    if (cp >= 0x3000 && cp <= 0x303F) return CP_SEP;                // CJK punctuation
+    if (cp >= 0xE000 && cp <= 0xF8FF) return CP_SEP;                // private use
+    if (cp >= 0xFE00 && cp <= 0xFE0F) return CP_MARK;               // variation selectors
+    if (cp >= 0xFE30 && cp <= 0xFE4F) return CP_SEP;
+    if (cp >= 0xFF00 && cp <= 0xFF0F) return CP_SEP;                // fullwidth punctuation
+    if (cp >= 0xFFF0 && cp <= 0xFFFF) return CP_SEP;                // specials
+    if (cp >= 0x1F000 && cp <= 0x1FAFF) return CP_SEP;              // emoji, pictographs
+    return CP_LETTER;
+}
+
+// Simple lowercase mapping for the cased scripts common in author names
+inline uint32_t toLower(uint32_t cp) {
+    if (cp >= 0xC0 && cp <= 0xDE) return cp + 0x20;                 // Latin-1 (x excluded by classify)
+    if ((cp >= 0x0100 && cp <= 0x0137) || (cp >= 0x014A && cp <= 0x0177))
+        return cp | 1;                                              // Latin Extended-A, even = upper
+    if ((cp >= 0x0139 && cp <= 0x0148) || (cp >= 0x0179 && cp <= 0x017E))
+        return (cp & 1) ? cp + 1 : cp;                              // odd = upper
+    if (cp == 0x0178) return 0xFF;
+    if (cp >= 0x0391 && cp <= 0x03AB && cp != 0x03A2) return cp + 0x20; // Greek
+    if (cp >= 0x0410 && cp <= 0x042F) return cp + 0x20;             // Cyrillic
+    if (cp >= 0x0400 && cp <= 0x040F) return cp + 0x50;
+    return cp;
+}
+
+inline void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Hash/equality for unordered containers keyed by std::string that should
+// be probed with string_view tokens without allocating
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+} // namespace tokenizer
+
+// ===================== TOKENIZER =====================
+
+class Tokenizer {
+private:
+    std::string buffer;                              // normalized token bytes
+    std::vector<std::pair<uint32_t, uint32_t>> spans; // (offset, length) into buffer
+    std::vector<std::string_view> tokens;
+    bool dropStopWords;
+
+public:
+    explicit Tokenizer(bool skipStopWords = true) : dropStopWords(skipStopWords) {}
+
+    // Normalized tokens of `text`, in order. The views point into this
+    // tokenizer's buffer and stay valid until the next call.
+    const std::vector<std::string_view>& tokenize(std::string_view text) {
+        using namespace tokenizer;
+        buffer.clear();
+        spans.clear();
+        buffer.reserve(text.size());
+
+        const char* p = text.data();
+        const char* end = p + text.size();
+        size_t tokenStart = 0;
+        bool inToken = false;
+
+        auto finish = [&]() {
+            size_t len = buffer.size() - tokenStart;
+            if (len > 0 && !(dropStopWords && isStopWord(std::string_view(buffer).substr(tokenStart))))
+                spans.push_back({ static_cast<uint32_t>(tokenStart), static_cast<uint32_t>(len) });
+            else
+                buffer.resize(tokenStart);
+            inToken = false;
+        };
+
+        while (p < end) {
+            uint8_t cls = BYTE_CLASS[static_cast<uint8_t>(*p)];
+            if (cls == LOWER) {
+                if (!inToken) { tokenStart = buffer.size(); inToken = true; }
+                size_t n = lowerRun(p, end);
+                buffer.append(p, n);
+                p += n;
+                continue;
+            }
+            if (cls == UPPER || cls == DIGIT) {
+                if (!inToken) { tokenStart = buffer.size(); inToken = true; }
+                if (cls == UPPER) buffer += static_cast<char>(*p + ('a' - 'A'));
+                ++p;
+                continue;
+            }
+            if (cls >= LEAD2) {
+                uint32_t cp;
+                size_t n = decodeUtf8(p, end, cp);
+                CodePointClass cc = n ? classify(cp) : CP_SEP;
+                if (cc != CP_SEP) {
+                    if (!inToken) { tokenStart = buffer.size(); inToken = true; }
+                    if (cc == CP_LETTER) appendUtf8(buffer, toLower(cp));
+                    p += n;
+                    continue;
+                }
+                p += n ? n : 1;
+            } else {
+                ++p;
+            }
+            if (inToken) finish();
+        }
+        if (inToken) finish();
+
+        tokens.clear();
+        for (auto [off, len] : spans) tokens.emplace_back(buffer.data() + off, len);
+        return tokens;
+    }
+};
+
+#endif
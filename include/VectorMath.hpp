@@ -0,0 +1,66 @@
+#ifndef VECTOR_MATH_HPP
+#define VECTOR_MATH_HPP
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define VECTOR_MATH_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VECTOR_MATH_SSE2 1
+#endif
+
+// Dense float kernels for the embedding matrices. Vectors are normalized when
+// loaded, so cosine similarity is a plain dot product. dot() uses AVX2/FMA
+// when the build enables them (-mavx2 -mfma), SSE2 otherwise, and finishes
+// the last dim % 8 lanes in scalar code.
+
+namespace vecmath {
+
+inline float dot(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(VECTOR_MATH_AVX2)
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+    }
+    for (; i + 8 <= n; i += 8)
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+    __m256 s = _mm256_add_ps(s0, s1);
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+    sum = _mm_cvtss_f32(h);
+#elif defined(VECTOR_MATH_SSE2)
+    // Two accumulators hide the add latency
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 h = _mm_add_ps(s0, s1);
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+    sum = _mm_cvtss_f32(h);
+#endif
+    for (; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+// Scales v to unit length; false (v untouched) for a zero or non-finite vector
+inline bool normalize(float* v, size_t n) {
+    double sq = 0.0;
+    for (size_t i = 0; i < n; ++i) sq += double(v[i]) * v[i];
+    if (!(sq > 0.0) || !std::isfinite(sq)) return false;
+    float inv = static_cast<float>(1.0 / std::sqrt(sq));
+    for (size_t i = 0; i < n; ++i) v[i] *= inv;
+    return true;
+}
+
+} // namespace vecmath
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef WORD_VECTORS_HPP
+#define WORD_VECTORS_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "FlatTables.hpp"
+#include "VectorMath.hpp"
+
+// Pre-trained word embeddings for the semantic fallback, in any of the usual
+// formats:
+//
+//   word2vec binary - "<count> <dim>\n" then per word "<word> " + dim x f32
+//                     (little-endian); recognized by the ".bin" extension
+//   word2vec text   - the same header, then "<word> <v1> ... <vdim>" lines
+//   GloVe text      - word lines only, no header
+//
+// Words are lowercased like the tokenizer's terms; when that makes two equal
+// the first is kept (the files list frequent words first). Vectors are
+// normalized to unit length on load and stored row by row in one contiguous
+// matrix, so cosine similarity is vecmath::dot on two rows. Zero vectors and
+// lines whose width differs from the first are skipped.
+
+class WordVectors {
+private:
+    StringTable words;         // word -> row
+    std::vector<float> matrix; // rows x dim
+    size_t dim = 0;
+
+    static std::string lower(std::string_view w) {
+        std::string s(w);
+        for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return s;
+    }
+
+    // "<count> <dim>" header line -> dim, 0 if the line is not a header
+    static size_t headerDim(const std::string& line) {
+        char* end;
+        const char* p = line.c_str();
+        unsigned long long n = std::strtoull(p, &end, 10);
+        if (end == p) return 0;
+        p = end;
+        unsigned long long d = std::strtoull(p, &end, 10);
+        if (end == p || n == 0) return 0;
+        for (; *end; ++end)
+            if (!std::isspace(static_cast<unsigned char>(*end))) return 0;
+        return static_cast<size_t>(d);
+    }
+
+    // Word and values of a text line into `word` and `row`; false if malformed
+    static bool parseLine(const std::string& line, std::string& word, std::vector<float>& row) {
+        size_t sp = line.find(' ');
+        if (sp == std::string::npos || sp == 0) return false;
+        word.assign(line, 0, sp);
+        row.clear();
+        const char* p = line.c_str() + sp;
+        for (;;) {
+            char* end;
+            float v = std::strtof(p, &end);
+            if (end == p) break;
+            row.push_back(v);
+            p = end;
+        }
+        return !row.empty();
+    }
+
+    bool readText(std::ifstream& in, std::string first, size_t maxWords,
+                  std::vector<std::pair<std::string, uint32_t>>& items) {
+        std::string line = std::move(first), word;
+        std::vector<float> row;
+        bool more = true;
+        for (; more && (maxWords == 0 || items.size() < maxWords); more = static_cast<bool>(std::getline(in, line))) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!parseLine(line, word, row)) continue;
+            if (dim == 0) dim = row.size();
+            if (row.size() != dim) continue;
+            add(word, row.data(), items);
+        }
+        return dim > 0;
+    }
+
+    bool readBinary(std::ifstream& in, size_t maxWords, std::vector<std::pair<std::string, uint32_t>>& items) {
+        std::string word;
+        std::vector<float> row(dim);
+        while (maxWords == 0 || items.size() < maxWords) {
+            word.clear();
+            int c;
+            while ((c = in.get()) != EOF && std::isspace(c)) {}
+            for (; c != EOF && c != ' '; c = in.get()) word.push_back(static_cast<char>(c));
+            if (word.empty()) break;
+            if (!in.read(reinterpret_cast<char*>(row.data()), dim * sizeof(float))) return false;
+            add(word, row.data(), items);
+        }
+        return true;
+    }
+
+    void add(const std::string& word, float* row, std::vector<std::pair<std::string, uint32_t>>& items) {
+        if (!vecmath::normalize(row, dim)) return;
+        items.push_back({ lower(word), static_cast<uint32_t>(items.size()) });
+        matrix.insert(matrix.end(), row, row + dim);
+    }
+
+public:
+    bool load(const std::string& path, size_t maxWords = 0) {
+        words = StringTable();
+        matrix.clear();
+        dim = 0;
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return false;
+
+        std::string first;
+        if (!std::getline(in, first)) return false;
+        if (!first.empty() && first.back() == '\r') first.pop_back();
+        size_t d = headerDim(first);
+        bool binary = d > 0 && path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+
+        std::vector<std::pair<std::string, uint32_t>> items;
+        bool ok;
+        if (binary) {
+            dim = d;
+            ok = readBinary(in, maxWords, items);
+        } else if (d > 0) {
+            dim = d;
+            ok = std::getline(in, first) && readText(in, first, maxWords, items);
+        } else {
+            ok = readText(in, first, maxWords, items);
+        }
+        if (!ok || items.empty()) {
+            std::cerr << "[Vectors][ERROR] Malformed embeddings in " << path << "\n";
+            matrix.clear();
+            dim = 0;
+            return false;
+        }
+
+        // Keep the first of words that lowercase alike
+        std::unordered_set<std::string> seen;
+        size_t kept = 0;
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (!seen.insert(items[i].first).second) continue;
+            if (kept != i) {
+                std::copy_n(matrix.begin() + i * dim, dim, matrix.begin() + kept * dim);
+                items[kept].first = std::move(items[i].first);
+            }
+            items[kept].second = static_cast<uint32_t>(kept);
+            ++kept;
+        }
+        items.resize(kept);
+        matrix.resize(kept * dim);
+        matrix.shrink_to_fit();
+        words.assign(StringTable::build(items));
+        return true;
+    }
+
+    bool empty() const { return words.size() == 0; }
+    size_t size() const { return words.size(); }
+    size_t dimensions() const { return dim; }
+    size_t byteSize() const { return matrix.size() * sizeof(float) + words.byteSize(); }
+
+    const float* data() const { return matrix.data(); }
+    const float* row(uint32_t r) const { return matrix.data() + size_t(r) * dim; }
+    std::string_view word(uint32_t r) const { return words.key(r); }
+    bool find(std::string_view w, uint32_t& r) const { return words.find(w, r); }
+};
+
+#endif
@@ -4,9 +4,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <json.hpp>
-
-using json = nlohmann::json;
+#include "JsonFields.hpp"
 
 class AUC {
 private:
@@ -18,7 +16,10 @@ public:
     AUC(const std::string& jsonPath, const std::string& indexPath)
         : jsonFilePath(jsonPath), indexFilePath(indexPath) {}
 
-    // Generate index file
+    // Generate index file. Internal IDs are 1-based dataset line numbers,
+    // as in ForwardIndex; a line without a usable id gets no row, so IDs can
+    // have gaps and the row count is not the last ID (DynamicIndexer reads
+    // the largest one).
     bool createIndexFile() const {
         std::ifstream inFile(jsonFilePath, std::ios::binary);
         std::ofstream indexFile(indexFilePath);
@@ -35,16 +36,18 @@ public:
         // Write CSV header
         indexFile << "internal_doc_id,original_doc_id,start_offset,length\n";
 
-        std::string line;
+        std::string line, original_id;
         uint64_t offset = 0;
         unsigned int internal_id = 1;
+        JsonRecord obj{ "id" }; // only the id is needed, so nothing else is decoded
 
         while (std::getline(inFile, line)) {
             uint64_t length = line.size();  // length in bytes
-            json obj = json::parse(line);
-            std::string original_id = obj["id"];
+            original_id.clear();
 
-            indexFile << internal_id << "|" << original_id << "|" << offset << "|" << length << "\n";
+            // Unparseable records keep their line number (internal ID) but get no row
+            if (obj.scan(line) && obj.appendString(0, original_id))
+                indexFile << internal_id << "|" << original_id << "|" << offset << "|" << length << "\n";
 
             offset += length + 1; // +1 for newline
             internal_id++;
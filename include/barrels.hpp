@@ -7,75 +7,231 @@
 #include <string>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
+#include "PostingCodec.hpp"
+#include "BarrelDirectory.hpp"
 
 namespace fs = std::filesystem;
 
+// BarrelRouting maps word IDs to barrels. Barrels own contiguous word ID
+// ranges; firstWordID[b] is the lowest word ID stored in barrel b, and any
+// word ID past the last boundary (e.g. new terms added at runtime) routes to
+// the last barrel. Stored as "<dir>/routing.txt": barrel count, then one
+// boundary per line.
+
+struct BarrelRouting {
+    std::vector<uint32_t> firstWordID;
+
+    size_t barrelCount() const { return firstWordID.size(); }
+
+    int barrelFor(uint32_t wordID) const {
+        auto it = std::upper_bound(firstWordID.begin(), firstWordID.end(), wordID);
+        return it == firstWordID.begin() ? 0 : static_cast<int>(it - firstWordID.begin()) - 1;
+    }
+
+    bool load(const std::string& dir) {
+        std::ifstream in(dir + "/routing.txt");
+        size_t n;
+        if (!(in >> n)) return false;
+        firstWordID.assign(n, 0);
+        for (auto& w : firstWordID)
+            if (!(in >> w)) return false;
+        return n > 0;
+    }
+
+    bool save(const std::string& dir) const {
+        std::ofstream out(dir + "/routing.txt");
+        if (!out.is_open()) return false;
+        out << firstWordID.size() << "\n";
+        for (uint32_t w : firstWordID) out << w << "\n";
+        return true;
+    }
+};
+
 // BarrelGenerator handles splitting an inverted index into multiple barrel files.
-// Each barrel contains a subset of terms determined by wordID modulo totalBarrels.
-// An accompanying index file stores byte offsets for fast lookup.
+// Terms must arrive in ascending word ID order; a new barrel is started once
+// the current one reaches the target size, so barrels come out roughly equal
+// in bytes and the barrel count follows from corpus size / target size.
+// Barrels are binary (see PostingCodec.hpp); directory.bin locates every
+// record (see BarrelDirectory.hpp) and routing.txt stores the term ranges.
 
 class BarrelGenerator {
 private:
-    int totalBarrels;
+    uint64_t targetBarrelBytes;
     std::string outputDir;
 
+    std::ofstream barrelFile;
+    std::vector<DirectoryEntry> directory; // indexed by word ID
+    uint64_t barrelBytes = 0;
+    uint32_t lastWordID = 0;
+    BarrelRouting routing;
+    std::string record;
+
+    // Closes the current barrel; false if any of its bytes did not reach the file
+    bool finishBarrel() {
+        if (!barrelFile.is_open()) return true;
+        barrelFile.close();
+        if (barrelFile) return true;
+        std::cerr << "[Barrels][ERROR] Failed writing barrel " << routing.barrelCount() - 1 << "\n";
+        return false;
+    }
+
+    bool startBarrel(uint32_t firstWordID) {
+        if (!finishBarrel()) return false;
+
+        int i = static_cast<int>(routing.barrelCount());
+        barrelFile.open(outputDir + "/barrel_" + std::to_string(i) + ".bin", std::ios::binary);
+        if (!barrelFile.is_open()) {
+            std::cerr << "[Barrels][ERROR] Failed to open barrel file for barrel " << i << "\n";
+            return false;
+        }
+        routing.firstWordID.push_back(firstWordID);
+        barrelBytes = 0;
+        return true;
+    }
+
 public:
-    BarrelGenerator(int nBarrels = 1)
-        : totalBarrels(nBarrels), outputDir("bartest") {}
+    static constexpr uint64_t DEFAULT_TARGET_BYTES = 64ull * 1024 * 1024;
+
+    BarrelGenerator(const std::string& dir = "bartest", uint64_t targetBytes = DEFAULT_TARGET_BYTES)
+        : targetBarrelBytes(targetBytes), outputDir(dir) {}
+
+    // Prepares the output directory, removing barrels from a previous build
+    // and the postings added since (delta.bin), which the build folds in.
+    bool open() {
+        if (!fs::exists(outputDir))
+            fs::create_directories(outputDir);
+
+        for (const auto& entry : fs::directory_iterator(outputDir)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind("barrel_", 0) == 0 || name == "delta.bin") fs::remove(entry.path());
+        }
+        routing.firstWordID.clear();
+        directory.clear();
+        lastWordID = 0;
+        return true;
+    }
+
+    // Encodes one term's postings (sorted by doc ID) into the current barrel;
+    // with `positions` (see PostingList) the record is positional, with
+    // `impacts` (one per posting) it stores them.
+    bool writeTerm(uint32_t wordID, double idf, const std::vector<Posting>& postings,
+                   const std::vector<uint32_t>* positions = nullptr,
+                   const std::vector<uint8_t>* impacts = nullptr) {
+        if (routing.barrelCount() > 0 && wordID <= lastWordID) {
+            std::cerr << "[Barrels][ERROR] Terms out of order: " << wordID << " after " << lastWordID << "\n";
+            return false;
+        }
+        if (routing.barrelCount() == 0 || barrelBytes >= targetBarrelBytes)
+            if (!startBarrel(wordID)) return false;
+        lastWordID = wordID;
+
+        record.clear();
+        PostingCodec::encode(record, wordID, idf, postings, positions, impacts);
+
+        if (wordID >= directory.size()) directory.resize(wordID + 1);
+        directory[wordID] = { barrelBytes, static_cast<uint32_t>(record.size()),
+                              static_cast<uint32_t>(postings.size()),
+                              static_cast<uint32_t>(routing.barrelCount() - 1), 0 };
+        barrelFile.write(record.data(), record.size());
+        if (!barrelFile) {
+            std::cerr << "[Barrels][ERROR] Failed writing term " << wordID << " to barrel "
+                      << routing.barrelCount() - 1 << "\n";
+            return false;
+        }
+        barrelBytes += record.size();
+        return true;
+    }
+
+    // Flushes the last barrel and writes the directory and routing table.
+    bool close() {
+        if (!finishBarrel()) return false;
+        if (routing.barrelCount() == 0 && !startBarrel(0)) return false; // empty index: one empty barrel
+        if (!finishBarrel()) return false;
+        if (!BarrelDirectory::write(outputDir + "/directory.bin", directory)) {
+            std::cerr << "[Barrels][ERROR] Cannot write directory in " << outputDir << "\n";
+            return false;
+        }
+        if (!routing.save(outputDir)) {
+            std::cerr << "[Barrels][ERROR] Cannot write routing table in " << outputDir << "\n";
+            return false;
+        }
+        std::cout << "[Barrels] " << routing.barrelCount() << " barrel(s), target "
+                  << targetBarrelBytes / 1024 << " KB each\n";
+        return true;
+    }
 
     // Creates barrels and index files from the input inverted index file
-    // Input: path to inverted index file
-    // Output: barrel files and corresponding index files in outputDir
+    // Input: path to inverted index file ("wid idf : internalDocId(tf,mask[;positions]) ...")
+    // Output: barrel files, directory.bin and routing.txt in outputDir
 
     void createBarrels(const std::string& inputPath) {
         std::cout << "[Barrels] Creating barrels...\n";
 
-        if (!fs::exists(outputDir))
-            fs::create_directory(outputDir);
-
         std::ifstream infile(inputPath);
         if (!infile.is_open()) {
-        std::cerr << "[Barrels][ERROR] Cannot open inverted index: " << inputPath << "\n";
-        return;
+            std::cerr << "[Barrels][ERROR] Cannot open inverted index: " << inputPath << "\n";
+            return;
         }
 
         if (infile.peek() == std::ifstream::traits_type::eof()) {
-        std::cerr << "[Barrels][WARNING] Inverted index is empty: " << inputPath << "\n";
+            std::cerr << "[Barrels][WARNING] Inverted index is empty: " << inputPath << "\n";
         }
 
-        std::vector<std::ofstream> barrelFiles(totalBarrels);
-        std::vector<std::ofstream> indexFiles(totalBarrels);
-
-        for (int i = 0; i < totalBarrels; ++i) {
-        barrelFiles[i].open(outputDir + "/barrel_" + std::to_string(i) + ".txt");
-        indexFiles[i].open(outputDir + "/barrel_" + std::to_string(i) + ".idx");
-
-        if (!barrelFiles[i].is_open() || !indexFiles[i].is_open()) {
-        std::cerr << "[Barrels][ERROR] Failed to open barrel or index file for barrel " << i << "\n";
-        return;
-        }
-}
+        if (!open()) return;
 
         std::string line;
         long long count = 0;
+        std::vector<Posting> postings;
+        std::vector<uint32_t> positions, sortedPositions;
+        std::vector<size_t> positionStart, order;
 
         while (std::getline(infile, line)) {
             if (line.empty()) continue;
 
             std::stringstream ss(line);
-            int wordID;
-            ss >> wordID;
-
-            int bID = wordID % totalBarrels;
-
-            long long offset = barrelFiles[bID].tellp();
-            indexFiles[bID] << wordID << " " << offset << "\n";
-            barrelFiles[bID] << line << "\n";
+            unsigned int wordID;
+            double idf;
+            std::string colon, token;
+            if (!(ss >> wordID >> idf >> colon)) continue;
+
+            postings.clear();
+            positions.clear();
+            positionStart.clear();
+            bool positional = true;
+            while (ss >> token) {
+                Posting p{};
+                size_t before = positions.size();
+                if (!PostingCodec::parseText(token, p.docId, p, positions)) continue;
+                if (positions.size() - before != p.tf) positional = false;
+                positionStart.push_back(before);
+                postings.push_back(p);
+            }
+
+            // Sort by doc ID, carrying each posting's positions along
+            order.resize(postings.size());
+            for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+            std::stable_sort(order.begin(), order.end(),
+                             [&](size_t a, size_t b) { return postings[a].docId < postings[b].docId; });
+            std::vector<Posting> sorted;
+            sorted.reserve(postings.size());
+            sortedPositions.clear();
+            for (size_t i : order) {
+                sorted.push_back(postings[i]);
+                if (positional)
+                    sortedPositions.insert(sortedPositions.end(), positions.begin() + positionStart[i],
+                                           positions.begin() + positionStart[i] + postings[i].tf);
+            }
+            postings.swap(sorted);
+            positional = positional && !postings.empty();
+            if (!writeTerm(wordID, idf, postings, positional ? &sortedPositions : nullptr)) return;
 
             if (++count % 500000 == 0)
                 std::cout << "[Barrels] Processed " << count << " entries...\n";
         }
 
+        if (!close()) return;
+
         // Print Total Count
         std::cout << "[Barrels] Done. Total entries: " << count << "\n";
     }
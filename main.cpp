@@ -17,6 +17,11 @@
 #include "include/SearchEngine.hpp"
 #include "include/barrels.hpp"
 #include "include/DynamicIndexer.hpp"
+#include "include/IndexBuilder.hpp"
+#include "include/EngineSnapshot.hpp"
+#include "include/Lexiconfolder.hpp"
+#include "include/IndexRemap.hpp"
+#include "include/ResultCache.hpp"
 #include "include/external/httplib.h"
 #include <chrono>
 
@@ -27,14 +32,98 @@ using Clock1 = std::chrono::high_resolution_clock;
 namespace fs = std::filesystem;
 using namespace httplib;
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
         std::locale::global(std::locale(""));
     } catch (...) {
         std::cerr << "Warning: Failed to set global UTF-8 locale.\n";
     }
+
+    // BUILD MODE: StellarTrace build <dataset.json> [outputDir] [memoryMB] [--positions]
+    // Single pass over the dataset: lexicon, doc map and barrels. --positions
+    // stores word positions too, which phrase and proximity queries need.
+    if (argc >= 3 && string(argv[1]) == "build") {
+        vector<string> args;
+        bool positions = false;
+        for (int i = 2; i < argc; ++i) {
+            if (string(argv[i]) == "--positions") positions = true;
+            else args.push_back(argv[i]);
+        }
+        if (args.empty()) {
+            cerr << "Usage: build <dataset.json> [outputDir] [memoryMB] [--positions]\n";
+            return 1;
+        }
+        IndexBuilder builder(args[0], args.size() >= 2 ? args[1] : ".",
+                             args.size() >= 3 ? stoul(args[2]) : 1024, positions);
+        return builder.build() ? 0 : 1;
+    }
+
+    // MERGE MODE: StellarTrace merge-lexicons <folder> [outputDir] [threads]
+    // Combined lexicon plus one old -> new word ID remap table per input.
+    if (argc >= 3 && string(argv[1]) == "merge-lexicons") {
+        LexiconFolder folder(argv[2], argc >= 4 ? argv[3] : ".", argc >= 5 ? stoul(argv[4]) : 0);
+        return folder.mergeLexicons() ? 0 : 1;
+    }
+
+    // REMAP MODES: rewrite a shard's index to the combined word IDs
+    //   StellarTrace remap-forward <table.remap> <forwardIn> <forwardOut> [docOffset]
+    //   StellarTrace remap-barrels <table.remap> <barrelDirIn> <barrelDirOut> [docOffset]
+    if (argc >= 5 && (string(argv[1]) == "remap-forward" || string(argv[1]) == "remap-barrels")) {
+        RemapTable remap;
+        if (!remap.load(argv[2])) {
+            cerr << "[Remap][ERROR] Cannot read remap table: " << argv[2] << "\n";
+            return 1;
+        }
+        uint32_t docOffset = argc >= 6 ? static_cast<uint32_t>(stoul(argv[5])) : 0;
+        bool ok = string(argv[1]) == "remap-forward"
+            ? IndexRemapper::remapForwardIndex(remap, argv[3], argv[4], docOffset)
+            : IndexRemapper::remapBarrels(remap, argv[3], argv[4], docOffset);
+        return ok ? 0 : 1;
+    }
+
+    const string autocompleteLexiconPath = "Lexicon/Lexicon (arxiv-metadata).txt";
+    const string lexiconPath =
+        "/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/Lexicon/Lexicon (arxiv-metadata).txt";
+    const string docMapPath = "/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/AUC.csv";
+    const string snapshotPath = "/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/engine.snap";
+    const string docVectorsPath = "/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/docvecs.bin";
+
     Autocomplete autocomplete;
-    autocomplete.loadLexicon("Lexicon/Lexicon (arxiv-metadata).txt");
+    SearchEngine engine;
+
+    auto loadTextState = [&]() {
+        autocomplete.loadLexicon(autocompleteLexiconPath);
+        engine.loadLexicon(lexiconPath);
+        engine.loadDocMap(docMapPath);
+    };
+
+    // SNAPSHOT MODE: StellarTrace snapshot [image]
+    // Bakes the lexicon, doc table and autocomplete prefixes into one image
+    // that the server maps at startup instead of parsing the text files.
+    if (argc >= 2 && string(argv[1]) == "snapshot") {
+        auto t0 = Clock1::now();
+        loadTextState();
+        SnapshotWriter writer;
+        writer.addSource(autocompleteLexiconPath);
+        writer.addSource(lexiconPath);
+        writer.addSource(docMapPath);
+        engine.saveSnapshot(writer);
+        autocomplete.saveSnapshot(writer);
+        bool ok = writer.write(argc >= 3 ? argv[2] : snapshotPath);
+        cout << "[TIME] Snapshot took "
+             << chrono::duration_cast<chrono::milliseconds>(Clock1::now() - t0).count() << " ms\n";
+        return ok ? 0 : 1;
+    }
+
+    // DOC VECTORS MODE: StellarTrace doc-vectors <embeddings.txt> [docvecs.bin]
+    // Converts precomputed document embeddings ("<id> <v1> ... <vdim>" lines,
+    // see sample_semantic.py) to the mapped file /semantic searches, and
+    // builds its graph so the server does not have to.
+    if (argc >= 3 && string(argv[1]) == "doc-vectors") {
+        engine.loadDocMap(docMapPath);
+        string out = argc >= 4 ? argv[3] : docVectorsPath;
+        return engine.writeDocVectors(argv[2], out) && engine.loadDocVectors(out) ? 0 : 1;
+    }
 
     // PHASE 1: BUILD BARRELS
     cout << "--- PHASE 1: GENERATING BARRELS ---" << endl;
@@ -43,29 +132,59 @@ int main() {
     cout << "\n--- PHASE 2: INITIALIZING SEARCH ENGINE ---" << endl;
     auto t3 = Clock1::now();
 
-    SearchEngine engine;
-
-    engine.loadLexicon(
-        "/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/Lexicon/Lexicon (arxiv-metadata).txt"
-    );
-
-    engine.loadDocMap(
-        "/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/AUC.csv"
-    );
+    // Prefer the snapshot; fall back to the text files if it is missing,
+    // corrupt or older than its sources.
+    auto image = make_shared<SnapshotImage>();
+    bool fromSnapshot = image->open(snapshotPath) &&
+                        engine.loadSnapshot(image) && autocomplete.loadSnapshot(image);
+    if (!fromSnapshot) loadTextState();
 
     engine.loadBarrels();
+    engine.setPostingCacheBudget(256u << 20);
 
     engine.setDatasetPath(
         "/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/Dataset/arxiv-metadata.json"
     );
+    engine.loadDocStore("/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/docs.bin");
+    if (engine.loadDocLengths("/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/doclens.bin"))
+        engine.setRanking(Ranking::BM25);
+    // word2vec (.bin or text) or GloVe vectors; the most frequent 400k words
+    engine.loadWordVectors("/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/Embeddings/word-vectors.txt",
+                           400000);
+    engine.setSemanticThreshold(0.7f);
+    engine.loadDocVectors(docVectorsPath);
 
     auto t4 = Clock1::now();
     cout << "[TIME] Engine initialization took "
          << chrono::duration_cast<chrono::milliseconds>(t4 - t3).count()
-         << " ms\n";
+         << " ms (" << (fromSnapshot ? "snapshot" : "text files") << ")\n";
 
     cout << "[OK] Search engine ready\n";
 
+    // BENCHMARK MODES: StellarTrace bench-and|bench-topk|bench-semantic|bench-pages <queries.txt> [rounds]
+    // bench-and compares the sorted-array AND against the old hash-map
+    // version, bench-topk block-max top-k against exhaustive scoring,
+    // bench-semantic the semantic graph against a scan of the word vectors
+    // and bench-pages cursor against offset paging (rounds = pages), on one
+    // query (for bench-semantic, one word) per line, and exits.
+    if (argc >= 3 && (string(argv[1]) == "bench-and" || string(argv[1]) == "bench-topk" ||
+                      string(argv[1]) == "bench-semantic" || string(argv[1]) == "bench-pages")) {
+        ifstream in(argv[2]);
+        vector<string> queries;
+        for (string q; getline(in, q); )
+            if (!q.empty()) queries.push_back(q);
+        if (queries.empty()) {
+            cerr << "[Bench][ERROR] No queries in " << argv[2] << "\n";
+            return 1;
+        }
+        int rounds = argc >= 4 ? stoi(argv[3]) : 20;
+        bool ok = string(argv[1]) == "bench-and" ? engine.benchmarkIntersection(queries, rounds)
+                : string(argv[1]) == "bench-topk" ? engine.benchmarkTopK(queries, rounds)
+                : string(argv[1]) == "bench-semantic" ? engine.benchmarkSemantic(queries, rounds)
+                                                      : engine.benchmarkPagination(queries, rounds);
+        return ok ? 0 : 1;
+    }
+
     // PHASE 2.5: INIT DYNAMIC INDEXER
     DynamicIndexer indexer(
         "/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/Dataset/arxiv-metadata.json",
@@ -75,14 +194,31 @@ int main() {
         "/home/aliakbar/CLionProjects/StellarTrace/cmake-build-debug/Barrels"
     );
 
+    // Serialized /search responses by normalized query; addDocument bumps the
+    // indexer's generation, which retires every cached entry
+    ResultCache resultCache(64u << 20);
+
     // PHASE 3: START HTTP SERVER
     cout << "\n--- PHASE 3: STARTING HTTP SERVER ---" << endl;
 
     Server svr;
 
-    // SEARCH
+    // Non-negative integer query parameter; fallback if absent or malformed
+    auto sizeParam = [](const Request& req, const char* name, size_t fallback) -> size_t {
+        if (!req.has_param(name)) return fallback;
+        string v = req.get_param_value(name);
+        char* end;
+        unsigned long long n = strtoull(v.c_str(), &end, 10);
+        return v.empty() || *end || v[0] == '-' ? fallback : static_cast<size_t>(n);
+    };
+
+    // SEARCH: /search?q=...[&rank=tfidf|bm25|impact][&k=10][&offset=0][&cursor=...]
+    // Ranking defaults to bm25. k results (up to 100) are returned after
+    // skipping `offset` (up to 1000); the X-Next-Cursor header, when present,
+    // continues from the end of this page when passed back as `cursor`.
     svr.Get("/search", [&](const Request& req, Response& res) {
         res.set_header("Access-Control-Allow-Origin", "*");
+        res.set_header("Access-Control-Expose-Headers", "X-Next-Cursor");
 
         if (!req.has_param("q")) {
             res.set_content("[]", "application/json");
@@ -92,17 +228,73 @@ int main() {
         string query = req.get_param_value("q");
 
         auto qs = Clock1::now();
-        auto results = engine.search(query);
+        Ranking chosen;
+        ParsedQuery parsed = req.has_param("rank") && ranking::parse(req.get_param_value("rank"), chosen)
+            ? engine.parseQuery(query, chosen)
+            : engine.parseQuery(query);
+        if (!engine.paginate(parsed, sizeParam(req, "k", 10), sizeParam(req, "offset", 0),
+                             req.has_param("cursor") ? req.get_param_value("cursor") : "")) {
+            res.status = 400;
+            res.set_content(R"({"status":"invalid k, offset or cursor"})", "application/json");
+            return;
+        }
+        string key = parsed.key, next;
+        uint64_t generation = indexer.generation();
+        auto cached = resultCache.get(key, generation, &next);
+        if (cached) {
+            res.set_content(*cached, "application/json");
+        } else {
+            string body = engine.search(std::move(parsed), &next);
+            res.set_content(body, "application/json");
+            resultCache.put(key, generation, std::move(body), next);
+        }
+        if (!next.empty()) res.set_header("X-Next-Cursor", next);
         auto qe = Clock1::now();
 
         auto durationMs =
             chrono::duration_cast<chrono::milliseconds>(qe - qs).count();
 
         cout << "[TIME] Query \"" << query
-             << "\" took " << durationMs << " ms\n";
+             << "\" took " << durationMs << " ms" << (cached ? " (cached)" : "") << "\n";
+    });
+
+    // SEMANTIC: /semantic?q=<query vector | document ID>[&text=...][&k=10]
+    // Nearest documents by embedding; with text, fused with the lexical
+    // results for it (hybrid)
+    svr.Get("/semantic", [&](const Request& req, Response& res) {
+        res.set_header("Access-Control-Allow-Origin", "*");
 
-        json response = results;
-        res.set_content(response.dump(), "application/json");
+        if (!req.has_param("q")) {
+            res.set_content("[]", "application/json");
+            return;
+        }
+
+        auto qs = Clock1::now();
+        string text = req.has_param("text") ? req.get_param_value("text") : "";
+        size_t k = std::min<size_t>(sizeParam(req, "k", 10), 100);
+        res.set_content(engine.semanticSearch(req.get_param_value("q"), text, k), "application/json");
+        auto durationMs = chrono::duration_cast<chrono::milliseconds>(Clock1::now() - qs).count();
+        cout << "[TIME] Semantic query" << (text.empty() ? "" : " \"" + text + "\"")
+             << " took " << durationMs << " ms\n";
+    });
+
+    svr.Get("/cachestats", [&](const Request&, Response& res) {
+        res.set_header("Access-Control-Allow-Origin", "*");
+        auto st = resultCache.stats();
+        auto ps = engine.postingCacheStats();
+        json j = {
+            {"results", {
+                {"hits", st.hits}, {"misses", st.misses}, {"evictions", st.evictions},
+                {"entries", st.entries}, {"bytes", st.bytes}, {"budget", st.budget},
+                {"generation", indexer.generation()}
+            }},
+            {"postings", {
+                {"hits", ps.hits}, {"misses", ps.misses}, {"admissions", ps.admissions},
+                {"rejections", ps.rejections}, {"evictions", ps.evictions},
+                {"entries", ps.entries}, {"bytes", ps.bytes}, {"budget", ps.budget}
+            }}
+        };
+        res.set_content(j.dump(), "application/json");
     });
     svr.Options("/adddoc", [&](const Request& req, Response& res) {
     res.set_header("Access-Control-Allow-Origin", "*");
@@ -151,8 +343,10 @@ int main() {
 
 
     cout << "Server running at:\n";
-    cout << "   GET  http://localhost:8080/search?q=your+query\n";
+    cout << "   GET  http://localhost:8080/search?q=your+query[&k=10][&offset=0][&cursor=...]\n";
+    cout << "   GET  http://localhost:8080/semantic?q=vector+or+doc+id[&text=your+query][&k=10]\n";
     cout << "   POST http://localhost:8080/adddoc\n";
+    cout << "   GET  http://localhost:8080/cachestats\n";
 
     svr.listen("0.0.0.0", 8080);
     return 0;
@@ -1,31 +1,71 @@
+import json
+import sys
+
 import requests
-from sentence_transformers import SentenceTransformer, util
+from sentence_transformers import SentenceTransformer
+
+# Dense search against the StellarTrace server.
+#
+#   python sample_semantic.py export <dataset.json> <embeddings.txt>
+#       Embeds every paper's title and abstract once and writes one
+#       "<id> <v1> ... <vdim>" line per paper. Convert the file for the server
+#       with `StellarTrace doc-vectors <embeddings.txt>`; the server maps the
+#       result and searches it in-process.
+#
+#   python sample_semantic.py [base_url]
+#       Embeds each query with the same model and asks /semantic for its
+#       neighbours, fused with the lexical results for the query text.
+
+MODEL = "all-MiniLM-L6-v2"
+
+
+def export(dataset_path, out_path, batch=256):
+    model = SentenceTransformer(MODEL)
+
+    def flush(ids, texts, out):
+        for doc_id, vec in zip(ids, model.encode(texts, batch_size=64)):
+            out.write(doc_id + " " + " ".join(f"{x:.6f}" for x in vec) + "\n")
+
+    with open(dataset_path, encoding="utf-8") as src, open(out_path, "w", encoding="utf-8") as out:
+        ids, texts = [], []
+        for line in src:
+            if not line.strip():
+                continue
+            paper = json.loads(line)
+            ids.append(paper["id"])
+            texts.append(paper.get("title", "") + ". " + paper.get("abstract", ""))
+            if len(ids) == batch:
+                flush(ids, texts, out)
+                ids, texts = [], []
+        if ids:
+            flush(ids, texts, out)
+
 
 class StellarTraceSemantic:
     def __init__(self, base_url="http://localhost:8080"):
         self.base_url = base_url.rstrip('/')
-        self.model = SentenceTransformer("all-MiniLM-L6-v2")
-        self.docs = []
-        self.emb = None
-
-    def load_docs(self):
-        r = requests.get(f"{self.base_url}/all")
-        data = r.json()
-        self.docs = [d.get("content", "") for d in data]
-        self.emb = self.model.encode(self.docs, convert_to_tensor=True)
-
-    def search(self, query, top_k=5):
-        q = self.model.encode(query, convert_to_tensor=True)
-        scores = util.pytorch_cos_sim(q, self.emb)[0]
-        idx = scores.topk(top_k).indices
-        return [self.docs[i] for i in idx]
+        self.model = SentenceTransformer(MODEL)
+
+    def search(self, query, hybrid=True):
+        vec = ",".join(f"{x:.6f}" for x in self.model.encode(query))
+        params = {"q": vec}
+        if hybrid:
+            params["text"] = query
+        return requests.get(f"{self.base_url}/semantic", params=params).json()
+
+    def similar(self, doc_id):
+        return requests.get(f"{self.base_url}/semantic", params={"q": doc_id}).json()
+
 
 if __name__ == "__main__":
-    s = StellarTraceSemantic()
-    s.load_docs()
+    if len(sys.argv) >= 4 and sys.argv[1] == "export":
+        export(sys.argv[2], sys.argv[3])
+        sys.exit(0)
 
+    s = StellarTraceSemantic(*sys.argv[1:2])
     while True:
         q = input("Search: ").strip()
         if q == "":
             break
-        print("Results:", s.search(q))
+        for r in s.search(q):
+            print(f"{r['relevance_score']:.4f}  {r['id']}  {r['title']}")